@@ -0,0 +1,306 @@
+/*
+	tuna                 maybe the tiniest C++ game framework
+	Copyright (C) 2026        imlobster <zhizhilik@gmail.com>
+
+	This Source Code Form is subject to the terms of the Mozilla Public
+	License, v. 2.0. If a copy of the MPL was not distributed with this
+	file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*/
+
+// tuna benchmarks:
+//     Builds worlds of different sizes and
+//     measures the world and object operations
+//     in nanoseconds and heap allocations
+//     per operation.
+//
+//     c++ -std=c++20 -O2 -DNDEBUG -I. bench/bench.cc -o tuna_bench -pthread
+//     ./tuna_bench [--objects 1000,10000] [--scripts 1,4,20] [--all]
+//
+//     Dispatch, kill and clean operations are
+//     counted per object, the rest per call.
+
+#include "tuna.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+	// Allocation counting
+
+// Replaced operators are paired with malloc and free
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<std::uint64_t> allocations = 0;
+
+void* operator new(std::size_t ibytes) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if(void* block = std::malloc(ibytes ? ibytes : 1)) return block;
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t ibytes, std::align_val_t ialignment) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	const std::size_t alignment = static_cast<std::size_t>(ialignment);
+	if(void* block = std::aligned_alloc(alignment, (ibytes + alignment - 1) / alignment * alignment)) return block;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* iblock) noexcept { std::free(iblock); }
+void operator delete(void* iblock, std::size_t) noexcept { std::free(iblock); }
+void operator delete(void* iblock, std::align_val_t) noexcept { std::free(iblock); }
+void operator delete(void* iblock, std::size_t, std::align_val_t) noexcept { std::free(iblock); }
+
+	// Scripts
+
+// Saved state of every benchmark script
+struct State : tuna::Script {
+	float value = 0.0f;
+	void save(tuna::Writer& iwriter) const { iwriter.write(value); return; }
+	void load(tuna::Reader& ireader) { value = ireader.read<float>(); return; }
+};
+
+// Script overriding one game loop method
+template<std::size_t HOOK> struct Hook;
+template<> struct Hook<0> : State { void loop(const float DELTA_TIME) override { value += DELTA_TIME; } };
+template<> struct Hook<1> : State { void step(const float DELTA_TIME) override { value += DELTA_TIME; } };
+template<> struct Hook<2> : State { void post(const float DELTA_TIME) override { value += DELTA_TIME; } };
+template<> struct Hook<3> : State { void drew(const float DELTA_TIME) override { value += DELTA_TIME; } };
+
+// Benchmark script:
+//     Every script type overrides one of the
+//     game loop methods, in turn.
+template<std::size_t N>
+struct Bench : Hook<N % 4> {};
+
+// Most scripts an object gets
+static constexpr std::size_t script_types = 20;
+
+// Grant the first icount script types
+template<std::size_t... N>
+static void grant(tuna::Object& iobject, std::size_t icount, std::index_sequence<N...>) {
+	((N < icount ? (void)iobject.grant<Bench<N>>() : (void)0), ...);
+	return;
+}
+
+// Register every script type for World::save()
+template<std::size_t... N>
+static void serializable(std::index_sequence<N...>) {
+	(tuna::serializable<Bench<N>>("Bench<" + std::to_string(N) + ">"), ...);
+	return;
+}
+
+// Seek a script type chosen at run time
+template<std::size_t... N>
+static bool seek(tuna::Object& iobject, std::size_t itype, std::index_sequence<N...>) {
+	bool found = false;
+	((N == itype ? (void)(found = !iobject.seek<Bench<N>>().expired()) : (void)0), ...);
+	return found;
+}
+
+	// Components
+
+struct Position { float x = 0.0f, y = 0.0f; };
+struct Velocity { float x = 1.0f, y = 1.0f; };
+
+	// Measurement
+
+struct Result {
+	double nanoseconds;
+	double allocations;
+};
+
+// Run ibody once and divide the cost by iops
+template<typename FN>
+static Result measure(std::size_t iops, FN&& ibody) {
+	const std::uint64_t allocations_before = allocations.load();
+	const auto begin = std::chrono::steady_clock::now();
+	ibody();
+	const auto end = std::chrono::steady_clock::now();
+	const std::uint64_t allocations_after = allocations.load();
+
+	const double ops = double(iops ? iops : 1);
+	return Result{
+		std::chrono::duration<double, std::nano>(end - begin).count() / ops,
+		double(allocations_after - allocations_before) / ops
+	};
+}
+
+static void report(const char* iname, std::size_t iobjects, std::size_t iscripts, Result iresult) {
+	std::printf("%-24s %10zu %8zu %14.2f %12.3f\n", iname, iobjects, iscripts, iresult.nanoseconds, iresult.allocations);
+	return;
+}
+
+// Keep the optimizer from dropping results
+static volatile std::size_t sink = 0;
+
+	// Benchmarks
+
+static void run(std::size_t iobjects, std::size_t iscripts) {
+	constexpr auto TYPES = std::make_index_sequence<script_types>();
+
+	tuna::World world;
+	std::vector<tuna::ObjectID> ids;
+	ids.reserve(iobjects);
+	std::vector<std::shared_ptr<tuna::Object>> objects;
+	objects.reserve(iobjects);
+
+	report("World::create", iobjects, iscripts, measure(iobjects, [&](void) {
+		for(std::size_t i = 0; i < iobjects; ++i) {
+			auto object = world.create().lock();
+			ids.emplace_back(object->id);
+			objects.emplace_back(std::move(object));
+		}
+	}));
+
+	report("Object::grant", iobjects, iscripts, measure(iobjects * iscripts, [&](void) {
+		for(auto& object : objects) grant(*object, iscripts, TYPES);
+	}));
+
+	report("Object::grant (again)", iobjects, iscripts, measure(iobjects * iscripts, [&](void) {
+		for(auto& object : objects) grant(*object, iscripts, TYPES);
+	}));
+
+	report("Object::seek<T>", iobjects, iscripts, measure(iobjects * 3, [&](void) {
+		std::size_t found = 0;
+		for(auto& object : objects) {
+			found += seek(*object, 0, TYPES);
+			found += seek(*object, iscripts / 2, TYPES);
+			found += seek(*object, iscripts - 1, TYPES);
+		}
+		sink = found;
+	}));
+
+	report("World::seek", iobjects, iscripts, measure(iobjects, [&](void) {
+		std::size_t found = 0;
+		for(tuna::ObjectID id : ids) found += !world.seek(id).expired();
+		sink = found;
+	}));
+
+	objects.clear();
+
+	report("dispatch<loop>", iobjects, iscripts, measure(iobjects, [&](void) { world.dispatch<&tuna::Script::loop>(0.016f); }));
+	report("dispatch<step>", iobjects, iscripts, measure(iobjects, [&](void) { world.dispatch<&tuna::Script::step>(0.02f); }));
+	report("dispatch<post>", iobjects, iscripts, measure(iobjects, [&](void) { world.dispatch<&tuna::Script::post>(0.016f); }));
+	report("dispatch<drew>", iobjects, iscripts, measure(iobjects, [&](void) { world.dispatch<&tuna::Script::drew>(0.016f); }));
+	report("dispatch<T, loop>", iobjects, iscripts, measure(iobjects, [&](void) { world.dispatch<Bench<0>, &Bench<0>::loop>(0.016f); }));
+
+	report("World::attach", iobjects, iscripts, measure(iobjects * 2, [&](void) {
+		for(tuna::ObjectID id : ids) {
+			world.attach<Position>(id);
+			world.attach<Velocity>(id);
+		}
+	}));
+	report("World::each", iobjects, iscripts, measure(iobjects, [&](void) {
+		world.each<Position, Velocity>([](Position& iposition, const Velocity& ivelocity) {
+			iposition.x += ivelocity.x * 0.016f;
+			iposition.y += ivelocity.y * 0.016f;
+		});
+	}));
+
+	// Objects stand on a square grid, one unit apart
+	const std::size_t side = std::size_t(std::sqrt(double(iobjects))) + 1;
+	world.partition(4.0f);
+	report("World::place", iobjects, iscripts, measure(iobjects, [&](void) {
+		for(std::size_t i = 0; i < ids.size(); ++i) {
+			const float x = float(i % side), y = float(i / side);
+			world.place(ids[i], tuna::Bounds{ x, y, x + 0.5f, y + 0.5f });
+		}
+	}));
+	std::vector<tuna::ObjectID> near;
+	report("World::query_radius", iobjects, iscripts, measure(iobjects, [&](void) {
+		std::size_t found = 0;
+		for(std::size_t i = 0; i < ids.size(); ++i) {
+			near.clear();
+			world.query_radius(float(i % side), float(i / side), 2.0f, near);
+			found += near.size();
+		}
+		sink = found;
+	}));
+
+	std::vector<std::byte> blob;
+	report("World::save", iobjects, iscripts, measure(iobjects, [&](void) { world.save(blob); }));
+	report("World::load", iobjects, iscripts, measure(iobjects, [&](void) { world.load(blob); }));
+	report("World::restore", iobjects, iscripts, measure(iobjects, [&](void) { world.restore(blob); }));
+	sink = blob.size();
+
+	// Every hundredth object is killed before a whole frame
+	std::size_t killed = 0;
+	report("World::kill", iobjects, iscripts, measure(iobjects, [&](void) {
+		for(std::size_t i = 0; i < ids.size(); i += 100) killed += world.kill(ids[i]);
+	}));
+	report("frame + kills", iobjects, iscripts, measure(iobjects, [&](void) {
+		world.dispatch<&tuna::Script::loop>(0.016f);
+		world.dispatch<&tuna::Script::step>(0.02f);
+		world.dispatch<&tuna::Script::post>(0.016f);
+		world.dispatch<&tuna::Script::drew>(0.016f);
+	}));
+	sink = killed;
+
+	report("World::clean", iobjects, iscripts, measure(iobjects, [&](void) { world.clean(); }));
+	return;
+}
+
+// Prefabs have a fixed set of scripts, so this runs once per world size
+static void spawn(std::size_t iobjects) {
+	constexpr std::size_t SCRIPTS = 4;
+
+	tuna::World world;
+	const tuna::Prefab<Bench<0>, Bench<1>, Bench<2>, Bench<3>> prefab;
+	std::vector<tuna::ObjectID> ids;
+	report("World::spawn", iobjects, SCRIPTS, measure(iobjects, [&](void) { world.spawn(prefab, iobjects, ids); }));
+	return;
+}
+
+	// Entry point
+
+// Parse a comma separated list of sizes
+static std::vector<std::size_t> sizes(const char* ilist) {
+	std::vector<std::size_t> parsed;
+	for(const char* cursor = ilist; *cursor;) {
+		char* end = nullptr;
+		parsed.emplace_back(std::strtoull(cursor, &end, 10));
+		if(*end != ',') break;
+		cursor = end + 1;
+	}
+	return parsed;
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::size_t> objects = { 1000, 10000, 100000, 1000000 };
+	std::vector<std::size_t> scripts = { 1, 4, 20 };
+	bool all = false;
+
+	for(int i = 1; i < argc; ++i) {
+		if(!std::strcmp(argv[i], "--objects") && i + 1 < argc) objects = sizes(argv[++i]);
+		else if(!std::strcmp(argv[i], "--scripts") && i + 1 < argc) scripts = sizes(argv[++i]);
+		else if(!std::strcmp(argv[i], "--all")) all = true;
+		else {
+			std::fprintf(stderr, "usage: %s [--objects N,...] [--scripts N,...] [--all]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	serializable(std::make_index_sequence<script_types>());
+	tuna::serializable<Position>("Position");
+	tuna::serializable<Velocity>("Velocity");
+	std::printf("%-24s %10s %8s %14s %12s\n", "benchmark", "objects", "scripts", "ns/op", "allocs/op");
+	for(std::size_t object_count : objects) {
+		for(std::size_t script_count : scripts) {
+			if(!script_count || script_count > script_types) continue;
+			// Huge worlds need many gigabytes of memory
+			if(!all && object_count * script_count > 4000000) continue;
+			run(object_count, script_count);
+		}
+		if(all || object_count * 4 <= 4000000) spawn(object_count);
+	}
+	return 0;
+}
@@ -9,12 +9,35 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <string_view>
 #include <memory>
+#include <memory_resource>
 #include <algorithm>
 #include <vector>
-#include <unordered_map>
-#include <unordered_set>
+#include <span>
+#include <compare>
+#include <iterator>
+#include <type_traits>
+#include <future>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <tuple>
+#include <utility>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#ifdef TUNA_PROFILE
+#include <array>
+#include <typeinfo>
+#endif
 
 namespace tuna {
 
@@ -27,23 +50,293 @@ class Script;
 // Game object:
 //     Script container.
 class Object;
-// Game object identifier
+// Game object identifier:
+//     Slot index in the lower half,
+//     slot generation in the upper half.
 using ObjectID = std::uint64_t;
+// Identifier that never belongs to an object
+inline constexpr ObjectID no_object = -1;
+// Object container:
+//     Dense slot map of objects.
+class Objects;
 // Game world:
 //     Manages objects and the game loop.
 class World;
+// Job system:
+//     Work-stealing thread pool
+//     for parallel dispatches.
+class Jobs;
+// Concurrent script marker:
+//     Inherit the script from this class
+//     too if its game loop methods are safe
+//     to run in parallel with each other.
+struct Concurrent {};
+// Axis-aligned bounds:
+//     Area an object takes in the
+//     world's spatial index.
+struct Bounds {
+	float min_x, min_y, max_x, max_y;
+};
+// Lightweight handle:
+//     Non-owning reference to an object
+//     or a script, checked without atomics.
+template<typename T> class Ref;
+// Serialization streams:
+//     Binary output and input for
+//     World::save() and World::load().
+class Writer;
+class Reader;
+// Rollback history:
+//     Ring of saved frames of a world.
+class History;
+// Prefab:
+//     Prototype scripts to make
+//     many alike objects at once.
+template<typename... SCRIPTS> class Prefab;
+// World group:
+//     Worlds stepped in parallel
+//     on the shared job system.
+class Universe;
+// Script coroutine:
+//     Resumed by the world's fixed
+//     steps once it is due.
+class Task;
+// Phase graph:
+//     Typed dispatches with declared
+//     data access, independent ones
+//     running in parallel.
+class Schedule;
+// Data access of a phase
+template<typename... TS> struct Reads {};
+template<typename... TS> struct Writes {};
+
+	// Type identifiers
+
+namespace detail {
+
+// Type registry:
+//     Sizes by type identifier. Worlds on
+//     different threads may meet new types
+//     at the same time, so it takes a lock.
+struct Types {
+	std::mutex lock;
+	std::vector<std::size_t> sizes;
+};
+
+inline Types& types(void) {
+	static Types registry;
+	return registry;
+}
+
+// Next unused script type identifier
+inline std::size_t next_type(std::size_t isize) {
+	Types& registry = types();
+	std::scoped_lock guard(registry.lock);
+	registry.sizes.emplace_back(isize);
+	return registry.sizes.size() - 1;
+}
+
+// Size of a type by its identifier
+inline std::size_t size_of(std::size_t itype) {
+	Types& registry = types();
+	std::scoped_lock guard(registry.lock);
+	return registry.sizes[itype];
+}
+
+// Script type identifier:
+//     Assigned once per type on first use,
+//     so exact type lookups need no RTTI.
+template<typename T>
+std::size_t type_of(void) {
+	static const std::size_t id = next_type(sizeof(T));
+	return id;
+}
+
+} // namespace detail
+
+	// Serialization streams
+
+class Writer {
+private:
+	std::vector<std::byte>& bytes;
+
+public:
+	// Writer appending to a blob
+	explicit Writer(std::vector<std::byte>& ibytes) : bytes(ibytes) { return; }
+
+	// Write raw bytes
+	void write(const void* idata, std::size_t isize) {
+		if(!isize) return;
+		const std::byte* data = static_cast<const std::byte*>(idata);
+		bytes.insert(bytes.end(), data, data + isize);
+		return;
+	}
+
+	// Write a value as it is in memory
+	template<typename T>
+	void write(const T& ivalue) {
+		static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values are written as they are");
+		write(&ivalue, sizeof(T));
+		return;
+	}
+
+	// Write a string with its length
+	void text(std::string_view istring) {
+		write(std::uint32_t(istring.size()));
+		write(istring.data(), istring.size());
+		return;
+	}
+
+	// Bytes written to the blob so far
+	std::size_t size(void) const { return bytes.size(); }
+
+	// Overwrite a value written before
+	template<typename T>
+	void patch(std::size_t iposition, const T& ivalue) {
+		std::memcpy(bytes.data() + iposition, &ivalue, sizeof(T));
+		return;
+	}
+};
+
+class Reader {
+private:
+	std::span<const std::byte> bytes;
+	std::size_t cursor = 0;
+	bool broken = false;
+
+public:
+	// Reader over a blob, which may be memory-mapped
+	explicit Reader(std::span<const std::byte> ibytes) : bytes(ibytes) { return; }
+
+	// Read raw bytes:
+	//     Reading past the end fails the
+	//     reader and yields zeroes from then on.
+	bool read(void* odata, std::size_t isize) {
+		if(!isize) return !broken;
+		if(broken || isize > bytes.size() - cursor) {
+			broken = true;
+			std::memset(odata, 0, isize);
+			return false;
+		}
+		std::memcpy(odata, bytes.data() + cursor, isize);
+		cursor += isize;
+		return true;
+	}
+
+	// Read a value written with Writer::write()
+	template<typename T>
+	T read(void) {
+		static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values are read as they are");
+		T value;
+		read(&value, sizeof(T));
+		return value;
+	}
+
+	// Read a string written with Writer::text()
+	std::string text(void) {
+		const std::uint32_t length = read<std::uint32_t>();
+		if(length > remaining()) {
+			broken = true;
+			return std::string();
+		}
+		std::string string(length, '\0');
+		read(string.data(), length);
+		return string;
+	}
+
+	// Skip bytes
+	bool skip(std::size_t isize) {
+		if(broken || isize > remaining()) {
+			broken = true;
+			return false;
+		}
+		cursor += isize;
+		return true;
+	}
+
+	std::size_t remaining(void) const { return bytes.size() - cursor; }
+	std::size_t position(void) const { return cursor; }
+
+	// Something could not be read
+	bool failed(void) const { return broken; }
+	// Mark the blob as malformed
+	void fail(void) {
+		broken = true;
+		return;
+	}
+};
 
 	// Core types implementation
 
 class Script {
+	friend class Object;
+	friend class World;
+
 public:
 	// Pointer to a script's parent
 	std::weak_ptr<Object> parent;
 
+	// Script's parent without locking:
+	//     Valid while the script is on the
+	//     object, nullptr once it is taken,
+	//     killed or outlives the object.
+	Object* object(void) const { return holder; }
+
+	// Dispatch order of the script type:
+	//     Redeclare it in your script to
+	//     change it. Lower goes first, equal
+	//     ones go in the order they were granted.
+	static constexpr int order = 0;
+
+private:
+	// Parent object, without ownership
+	Object* holder = nullptr;
+
+	// Script type identifier
+	std::size_t type = -1;
+
+	// Script runs in parallel dispatches
+	bool concurrent = false;
+
+	// Dispatch order and grant sequence number
+	int rank = 0;
+	std::uint64_t serial = 0;
+
+	// Mask of the game loop methods it overrides
+	unsigned hooks = 0;
+	// Update tier, 0 for every dispatch,
+	// and the bucket within the tier
+	std::uint32_t tier = 0;
+	std::uint32_t bucket = 0;
+	// Running time of the tier when it joined,
+	// so its first call there starts from it
+	double joined[4] = {};
+
+	// Script is left out of dispatches
+	bool asleep = false;
+
+	// Positions in the world's dispatch lists,
+	// the last one in the list of its own type
+	std::size_t slots[6] = { std::size_t(-1), std::size_t(-1), std::size_t(-1), std::size_t(-1), std::size_t(-1), std::size_t(-1) };
+
 public:
 	// Default destructor
 	virtual ~Script(void) = default;
 
+	// Dormancy:
+	//     A sleeping script is left out of
+	//     every dispatch and keeps its state
+	//     until it wakes up. Both are O(1) and
+	//     may be called while dispatching.
+	void sleep(void);
+	void wake(void);
+	bool sleeping(void) const { return asleep; }
+
+	// Start a coroutine of the script:
+	//     Same as World::start(), but the
+	//     task also ends when the script is taken.
+	bool start(Task&& itask);
+
 	// Game loop calls
 
 	// Loop call:
@@ -66,148 +359,4022 @@ public:
 	// "Must be called automatically" means you need to call them with World::dispatch()
 };
 
-class Object : public std::enable_shared_from_this<Object> {
+	// Coroutines
+
+// Coroutine run by the world:
+//     Write a script method returning
+//     tuna::Task and start it with
+//     Script::start() or World::start().
+//     The task runs until its first co_await
+//     right away and is resumed by the
+//     world's fixed steps after that.
+class Task {
+	friend class Script;
+	friend class World;
+
 public:
-	// Script container
-	std::vector<std::shared_ptr<Script>> scripts;
+	struct promise_type {
+		World* home = nullptr;
+		// Object and script the task belongs to
+		ObjectID owner = no_object;
+		std::size_t type = -1;
+		std::uint64_t serial = 0;
+		// Fixed step the task waits for
+		std::uint64_t due = 0;
 
-	// Object identifier
-	const ObjectID id;
+		Task get_return_object(void) { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend(void) noexcept { return {}; }
+		std::suspend_always final_suspend(void) noexcept { return {}; }
+		void return_void(void) { return; }
+		// Tasks are resumed from the game loop,
+		// there is nobody to hand an exception to
+		void unhandled_exception(void) { std::terminate(); }
+	};
+
+private:
+	std::coroutine_handle<promise_type> handle;
+
+	explicit Task(std::coroutine_handle<promise_type> ihandle) : handle(ihandle) { return; }
 
 public:
-	// Default constructor
-	Object(ObjectID iid) : id(iid) { return; }
+	// Default constructor, an empty task
+	Task(void) = default;
 
-	// Scripts manipulations
+	Task(Task&& iother) noexcept : handle(std::exchange(iother.handle, nullptr)) { return; }
+	Task& operator=(Task&& iother) noexcept {
+		if(this == &iother) return *this;
+		if(handle) handle.destroy();
+		handle = std::exchange(iother.handle, nullptr);
+		return *this;
+	}
 
-	// Find a script on the object and return iterator
-	template<typename T>
-	auto find(void) {
-		return std::find_if(scripts.begin(), scripts.end(),
-			[](const std::shared_ptr<Script>& iscript) {
-				return dynamic_cast<T*>(iscript.get()) != nullptr;
-			}
-		);
+	// Tasks never started are destroyed with their handle
+	~Task(void) {
+		if(handle) handle.destroy();
+		return;
 	}
+};
 
-	// Find a script on the object and return weak_ptr
-	template<typename T>
-	std::weak_ptr<T> seek(void) {
-		for(const auto& script : scripts)
-			if(auto casted = std::dynamic_pointer_cast<T>(script)) return casted;
-		return std::weak_ptr<T>();
+// Awaiter suspending a task:
+//     Given in fixed steps of the world,
+//     at least one.
+struct Wait {
+	float seconds;
+
+	bool await_ready(void) const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<Task::promise_type> ihandle) const;
+	void await_resume(void) const noexcept { return; }
+};
+
+// Suspend a task for some seconds:
+//     Counted in fixed steps of
+//     World::timestep(), rounded up.
+inline Wait wait(const float SECONDS) { return Wait{ SECONDS }; }
+// Suspend a task until the next fixed step
+inline Wait next_step(void) { return Wait{ 0.0f }; }
+
+	// Dispatch internals
+
+namespace detail {
+
+// Dispatch list index of a game loop method:
+//     Every game loop call has its own list
+//     of subscribed scripts. Any other method
+//     is dispatched over the list of all scripts.
+inline constexpr std::size_t every_hook = 4;
+template<auto METHOD> inline constexpr std::size_t hook_of = every_hook;
+template<> inline constexpr std::size_t hook_of<&Script::loop> = 0;
+template<> inline constexpr std::size_t hook_of<&Script::step> = 1;
+template<> inline constexpr std::size_t hook_of<&Script::post> = 2;
+template<> inline constexpr std::size_t hook_of<&Script::drew> = 3;
+
+// Slot of a script in the list of its own type
+inline constexpr std::size_t own_type = 5;
+
+// Game loop method of a script type:
+//     Template arguments naming the same
+//     method are the same, which holds for
+//     virtual methods too, unlike comparing
+//     member pointers.
+template<auto> struct Method {};
+template<typename T, auto METHOD>
+inline constexpr std::size_t own_hook_of =
+	std::is_same_v<Method<METHOD>, Method<&T::loop>> ? 0
+	: std::is_same_v<Method<METHOD>, Method<&T::step>> ? 1
+	: std::is_same_v<Method<METHOD>, Method<&T::post>> ? 2
+	: std::is_same_v<Method<METHOD>, Method<&T::drew>> ? 3
+	: hook_of<METHOD>;
+
+// Script inherits the default game loop method:
+//     Taking the address of a method that is not
+//     redeclared yields a pointer to Script's own.
+//     Anything unclear is treated as overridden.
+template<typename T> concept inherits_loop = std::is_same_v<decltype(&T::loop), void (Script::*)(const float)>;
+template<typename T> concept inherits_step = std::is_same_v<decltype(&T::step), void (Script::*)(const float)>;
+template<typename T> concept inherits_post = std::is_same_v<decltype(&T::post), void (Script::*)(const float)>;
+template<typename T> concept inherits_drew = std::is_same_v<decltype(&T::drew), void (Script::*)(const float)>;
+
+// Mask of the game loop methods a script overrides
+template<typename T>
+constexpr unsigned hooks_of(void) {
+	return (inherits_loop<T> ? 0u : 1u << hook_of<&Script::loop>)
+		| (inherits_step<T> ? 0u : 1u << hook_of<&Script::step>)
+		| (inherits_post<T> ? 0u : 1u << hook_of<&Script::post>)
+		| (inherits_drew<T> ? 0u : 1u << hook_of<&Script::drew>)
+		| 1u << every_hook;
+}
+
+// Script is safe to run in parallel
+template<typename T>
+inline constexpr bool is_concurrent = std::is_base_of_v<Concurrent, T>;
+
+// Reserve room for more elements:
+//     Capacity at least doubles, so
+//     keeping room for small batches
+//     stays amortized constant.
+template<typename T>
+void grow(std::vector<T>& ivector, std::size_t imore) {
+	if(ivector.capacity() - ivector.size() < imore) ivector.reserve(std::max(ivector.size() + imore, ivector.size() * 2));
+	return;
+}
+
+// No type is listed twice
+template<typename... TS>
+struct Distinct : std::true_type {};
+template<typename T, typename... TS>
+struct Distinct<T, TS...> : std::bool_constant<(!std::is_same_v<T, TS> && ...) && Distinct<TS...>::value> {};
+
+// Dispatch order key of a script
+struct Rank {
+	int order;
+	std::uint64_t serial;
+
+	friend constexpr auto operator<=>(const Rank&, const Rank&) = default;
+};
+
+// List of scripts subscribed to one method:
+//     Kept sorted by dispatch order. An append
+//     that breaks the order marks the list to be
+//     sorted before the next dispatch over it,
+//     and everything before it stays sorted.
+struct Roster {
+	std::vector<Script*> list;
+	std::size_t holes = 0;
+	Rank tail = { 0, 0 };
+	bool unsorted = false;
+	// Length of the sorted head while unsorted
+	std::size_t ordered = 0;
+};
+
+// Update tier:
+//     Scripts that only need every few
+//     dispatches of a game loop method are
+//     spread over as many buckets as the
+//     interval. One bucket runs per dispatch
+//     and gets the time passed since it last ran.
+struct Bucket {
+	Roster rosters[4];
+	// Running time of the tier when it last ran
+	double marks[4] = {};
+	std::size_t members = 0;
+	// Listed for the next sync point
+	bool dirty = false;
+};
+
+struct Tier {
+	static constexpr std::size_t max_interval = 1 << 16;
+
+	std::size_t interval;
+	std::size_t turns[4] = {};
+	std::vector<Bucket> buckets;
+	// Time every game loop method added up
+	double totals[4] = {};
+};
+
+// Component pool:
+//     Plain components of one type, stored
+//     contiguously and found by the slot
+//     index of their object's identifier.
+struct Pool {
+	static constexpr std::uint32_t vacant = -1;
+
+	// Identifiers of the owners, in component order
+	std::vector<ObjectID> owners;
+	// Component positions by object slot
+	std::vector<std::uint32_t> sparse;
+
+	virtual ~Pool(void) = default;
+
+	// Position of an object's component or vacant
+	std::uint32_t locate(ObjectID iid) const {
+		const std::uint32_t slot = std::uint32_t(iid);
+		if(slot >= sparse.size()) return vacant;
+		const std::uint32_t position = sparse[slot];
+		if(position == vacant || owners[position] != iid) return vacant;
+		return position;
 	}
 
-	// Grant a script to the object:
-	//     If the script has already
-	//     been provided to the object,
-	//     the method will return a
-	//     reference to it. Arguments passed
-	//     to the constructor will be ignored.
-	template<typename T, typename... ARGS>
-	std::weak_ptr<T> grant(ARGS&&... iargs) {
-		// If a script is already on the object -- return it
-		if(auto found = find<T>(); found != scripts.end())
-			return std::static_pointer_cast<T>(*found);
-
-		std::shared_ptr<T> script = std::make_shared<T>(std::forward<ARGS>(iargs)...);
-		std::weak_ptr<T> ref(script);
-		script->parent = shared_from_this();
-		scripts.emplace_back(std::move(script));
-		return ref;
+	virtual void erase(ObjectID iid) = 0;
+	virtual void clear(void) = 0;
+	// Bytes held and release of spare capacity
+	virtual std::size_t bytes(void) const = 0;
+	virtual void shrink(void) = 0;
+
+	// Raw component storage for serialization,
+	// with owners restored by load
+	virtual void save(Writer& iwriter) const = 0;
+	virtual bool load(Reader& ireader, std::uint64_t icount, std::size_t islots) = 0;
+};
+
+template<typename T>
+struct Components final : Pool {
+	std::vector<T> data;
+
+	T* find(ObjectID iid) {
+		const std::uint32_t position = locate(iid);
+		return position == vacant ? nullptr : &data[position];
 	}
 
-	// Take a script from the object
-	template<typename T>
-	bool take(void) {
-		auto found = find<T>();
-		if(found == scripts.end()) return false;
-		scripts.erase(found);
-		return true;
+	template<typename... ARGS>
+	T& emplace(ObjectID iid, ARGS&&... iargs) {
+		const std::uint32_t slot = std::uint32_t(iid);
+		if(slot >= sparse.size()) sparse.resize(std::size_t(slot) + 1, vacant);
+		data.emplace_back(std::forward<ARGS>(iargs)...);
+		sparse[slot] = std::uint32_t(owners.size());
+		owners.emplace_back(iid);
+		return data.back();
+	}
+
+	// The last component takes the erased one's place
+	void erase(ObjectID iid) override {
+		const std::uint32_t position = locate(iid);
+		if(position == vacant) return;
+		if(position != owners.size() - 1) {
+			data[position] = std::move(data.back());
+			owners[position] = owners.back();
+			sparse[std::uint32_t(owners[position])] = position;
+		}
+		data.pop_back();
+		owners.pop_back();
+		sparse[std::uint32_t(iid)] = vacant;
+		return;
+	}
+
+	void clear(void) override {
+		data.clear();
+		owners.clear();
+		sparse.clear();
+		return;
+	}
+
+	std::size_t bytes(void) const override {
+		return data.capacity() * sizeof(T) + owners.capacity() * sizeof(ObjectID) + sparse.capacity() * sizeof(std::uint32_t);
+	}
+
+	// Slots past the last component are dropped
+	void shrink(void) override {
+		while(!sparse.empty() && sparse.back() == vacant) sparse.pop_back();
+		data.shrink_to_fit();
+		owners.shrink_to_fit();
+		sparse.shrink_to_fit();
+		return;
+	}
+
+	void save(Writer& iwriter) const override {
+		if constexpr(std::is_trivially_copyable_v<T>) {
+			iwriter.write(owners.data(), owners.size() * sizeof(ObjectID));
+			iwriter.write(data.data(), data.size() * sizeof(T));
+		}
+		return;
+	}
+
+	bool load(Reader& ireader, std::uint64_t icount, std::size_t islots) override {
+		if constexpr(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>) {
+			if(icount > ireader.remaining() / (sizeof(ObjectID) + sizeof(T))) return false;
+			clear();
+			owners.resize(icount);
+			data.resize(icount);
+			ireader.read(owners.data(), owners.size() * sizeof(ObjectID));
+			ireader.read(data.data(), data.size() * sizeof(T));
+			for(std::size_t position = 0; position < owners.size(); ++position) {
+				const std::uint32_t slot = std::uint32_t(owners[position]);
+				if(slot >= islots) return false;
+				if(slot >= sparse.size()) sparse.resize(std::size_t(slot) + 1, vacant);
+				if(sparse[slot] != vacant) return false;
+				sparse[slot] = std::uint32_t(position);
+			}
+			return !ireader.failed();
+		}
+		else return false;
 	}
 };
 
-class World {
-public:
-	// Object container
-	std::unordered_map<ObjectID, std::shared_ptr<Object>> objects;
+// Spatial index:
+//     Uniform grid of square cells hashed into
+//     buckets, holding the bounds of objects by
+//     their slot index. Each object is listed in
+//     the buckets of the cells its bounds cover,
+//     and reported once per query, from the first
+//     covered cell that the query covers too, so
+//     queries change nothing and may run in parallel.
+struct Grid {
+	static constexpr std::uint32_t vacant = -1;
 
-private:
-	// Kill queue
-	std::unordered_set<ObjectID> kill_queue;
+	struct Entry {
+		ObjectID id;
+		Bounds bounds;
+		// Covered cells, inclusive
+		std::int32_t x0, y0, x1, y1;
+	};
 
-	// Global ObjectID
-	ObjectID last_id = -1;
+	float cell = 8.0f;
+	std::vector<Entry> entries;
+	// Entry positions by object slot
+	std::vector<std::uint32_t> sparse;
+	// Object slots by cell hash, size is a power of two
+	std::vector<std::vector<std::uint32_t>> buckets;
+	// Slots of entries covering more cells
+	// than there are buckets, seen by every query
+	std::vector<std::uint32_t> wide;
 
-public:
-	// Objects manipulations
+	// Cell of a coordinate, far and broken ones clamped
+	std::int32_t cell_of(float icoordinate) const {
+		constexpr float limit = float(1 << 30);
+		const float scaled = std::floor(icoordinate / cell);
+		return std::int32_t(!(scaled > -limit) ? -limit : scaled < limit ? scaled : limit);
+	}
 
-	// Clean the world
-	void clean(void) {
-		objects.clear();
-		kill_queue.clear();
-		last_id = -1;
+	// Range of cells is larger than the table
+	bool spans(std::int64_t ix0, std::int64_t iy0, std::int64_t ix1, std::int64_t iy1) const {
+		return (ix1 - ix0 + 1) * (iy1 - iy0 + 1) > std::int64_t(buckets.size());
+	}
+
+	std::size_t bucket_of(std::int32_t ix, std::int32_t iy) const {
+		return (std::uint32_t(ix) * 73856093u ^ std::uint32_t(iy) * 19349663u) & (buckets.size() - 1);
+	}
+
+	// Position of an object's entry or vacant
+	std::uint32_t locate(ObjectID iid) const {
+		const std::uint32_t slot = std::uint32_t(iid);
+		if(slot >= sparse.size()) return vacant;
+		const std::uint32_t position = sparse[slot];
+		if(position == vacant || entries[position].id != iid) return vacant;
+		return position;
+	}
+
+	// List an entry in the buckets of its cells,
+	// once per bucket
+	void link(const Entry& ientry) {
+		const std::uint32_t slot = std::uint32_t(ientry.id);
+		if(spans(ientry.x0, ientry.y0, ientry.x1, ientry.y1)) {
+			wide.emplace_back(slot);
+			return;
+		}
+		for(std::int32_t y = ientry.y0; y <= ientry.y1; ++y)
+			for(std::int32_t x = ientry.x0; x <= ientry.x1; ++x) {
+				auto& bucket = buckets[bucket_of(x, y)];
+				if(bucket.empty() || bucket.back() != slot) bucket.emplace_back(slot);
+			}
 		return;
 	}
 
-	// Create an object in the world
-	std::weak_ptr<Object> create(void) {
-		std::shared_ptr<Object> object = std::make_shared<Object>(++last_id);
-		std::weak_ptr<Object> ref(object);
-		objects.emplace(last_id, std::move(object));
-		return ref;
+	void unlink(const Entry& ientry) {
+		const std::uint32_t slot = std::uint32_t(ientry.id);
+		if(spans(ientry.x0, ientry.y0, ientry.x1, ientry.y1)) {
+			std::erase(wide, slot);
+			return;
+		}
+		for(std::int32_t y = ientry.y0; y <= ientry.y1; ++y)
+			for(std::int32_t x = ientry.x0; x <= ientry.x1; ++x) {
+				auto& bucket = buckets[bucket_of(x, y)];
+				auto found = std::find(bucket.begin(), bucket.end(), slot);
+				if(found == bucket.end()) continue;
+				*found = bucket.back();
+				bucket.pop_back();
+			}
+		return;
 	}
 
-	// Find the object in the world
-	std::weak_ptr<Object> seek(ObjectID iid) {
-		if(objects.empty()) [[unlikely]]
-			return std::weak_ptr<Object>();
-		auto found = objects.find(iid);
-		if(found == objects.end())
-			return std::weak_ptr<Object>();
-		return std::weak_ptr<Object>(found->second);
+	// Relist every entry in another amount of buckets
+	void rehash(std::size_t ibuckets) {
+		buckets.assign(ibuckets, {});
+		wide.clear();
+		for(const Entry& entry : entries) link(entry);
+		return;
 	}
 
-	// Kill the object in the world:
-	//     Despite its name, this method
-	//     does not kill the object
-	//     immediately. Instead, the object is
-	//     added to the kill queue
-	//     and will only be removed
-	//     on the next call to World::dispatch().
-	bool kill(ObjectID iid) {
-		if(!objects.contains(iid)) return false;
-		kill_queue.emplace(iid);
+	// Add or move an object's bounds:
+	//     Bounds that stay within the same
+	//     cells are only overwritten.
+	void place(ObjectID iid, Bounds ibounds) {
+		if(ibounds.max_x < ibounds.min_x) std::swap(ibounds.min_x, ibounds.max_x);
+		if(ibounds.max_y < ibounds.min_y) std::swap(ibounds.min_y, ibounds.max_y);
+		Entry entry{ iid, ibounds, cell_of(ibounds.min_x), cell_of(ibounds.min_y), cell_of(ibounds.max_x), cell_of(ibounds.max_y) };
+		if(const std::uint32_t position = locate(iid); position != vacant) {
+			Entry& placed = entries[position];
+			if(placed.x0 != entry.x0 || placed.y0 != entry.y0 || placed.x1 != entry.x1 || placed.y1 != entry.y1) {
+				unlink(placed);
+				link(entry);
+			}
+			placed = entry;
+			return;
+		}
+
+		const std::uint32_t slot = std::uint32_t(iid);
+		if(slot >= sparse.size()) sparse.resize(std::size_t(slot) + 1, vacant);
+		sparse[slot] = std::uint32_t(entries.size());
+		entries.emplace_back(entry);
+		if(entries.size() > buckets.size()) rehash(std::max<std::size_t>(buckets.size() * 2, 64));
+		else link(entry);
+		return;
+	}
+
+	// The last entry takes the erased one's place
+	bool erase(ObjectID iid) {
+		const std::uint32_t position = locate(iid);
+		if(position == vacant) return false;
+		unlink(entries[position]);
+		if(position != entries.size() - 1) {
+			entries[position] = entries.back();
+			sparse[std::uint32_t(entries[position].id)] = position;
+		}
+		entries.pop_back();
+		sparse[std::uint32_t(iid)] = vacant;
 		return true;
 	}
 
-	// Call a method on every object's script in the world
-	template<auto METHOD, typename... ARGS>
-	void dispatch(ARGS&&... iargs) {
-		if(objects.empty()) [[unlikely]] return;
+	void clear(void) {
+		entries.clear();
+		sparse.clear();
+		for(auto& bucket : buckets) bucket.clear();
+		wide.clear();
+		return;
+	}
 
-		std::vector<std::weak_ptr<Script>> actives, deads;
+	// Entries and buckets as they are, so a
+	// loaded index answers queries in the
+	// same order as the saved one
+	void save(Writer& iwriter) const {
+		iwriter.write(cell);
+		iwriter.write(std::uint64_t(entries.size()));
+		iwriter.write(entries.data(), entries.size() * sizeof(Entry));
+		iwriter.write(std::uint64_t(buckets.size()));
+		for(const auto& bucket : buckets) {
+			iwriter.write(std::uint64_t(bucket.size()));
+			iwriter.write(bucket.data(), bucket.size() * sizeof(std::uint32_t));
+		}
+		iwriter.write(std::uint64_t(wide.size()));
+		iwriter.write(wide.data(), wide.size() * sizeof(std::uint32_t));
+		return;
+	}
 
-		for(const auto& [objectid, object] : objects) if(object) [[likely]]
-			for(auto& script : object->scripts) if(script) [[likely]] {
-				if(kill_queue.contains(objectid)) deads.emplace_back(script);
-				else actives.emplace_back(script);
-			}
+	// Replace the index with a saved one:
+	//     Fails unless every entry is of one of
+	//     islots object slots, every listed slot
+	//     has an entry and the table is big enough.
+	//     Memory of the grid is reused.
+	bool load(Reader& ireader, std::size_t islots) {
+		clear();
+		cell = ireader.read<float>();
+		const std::uint64_t count = ireader.read<std::uint64_t>();
+		if(ireader.failed() || !(cell > 0.0f) || count > ireader.remaining() / sizeof(Entry)) return false;
+		entries.resize(count);
+		ireader.read(entries.data(), entries.size() * sizeof(Entry));
+		for(std::size_t position = 0; position < entries.size(); ++position) {
+			const std::uint32_t slot = std::uint32_t(entries[position].id);
+			if(slot >= islots) return false;
+			if(slot >= sparse.size()) sparse.resize(std::size_t(slot) + 1, vacant);
+			if(sparse[slot] != vacant) return false;
+			sparse[slot] = std::uint32_t(position);
+		}
+
+		auto listed = [&](std::vector<std::uint32_t>& olist) {
+			const std::uint64_t size = ireader.read<std::uint64_t>();
+			if(ireader.failed() || size > ireader.remaining() / sizeof(std::uint32_t)) return false;
+			olist.resize(size);
+			ireader.read(olist.data(), olist.size() * sizeof(std::uint32_t));
+			for(std::uint32_t slot : olist) if(slot >= sparse.size() || sparse[slot] == vacant) return false;
+			return true;
+		};
+		const std::uint64_t table = ireader.read<std::uint64_t>();
+		if(ireader.failed() || table > ireader.remaining() / sizeof(std::uint64_t) || (table & (table - 1)) || table < entries.size()) return false;
+		buckets.resize(table);
+		for(auto& bucket : buckets) if(!listed(bucket)) return false;
+		return listed(wide) && !ireader.failed();
+	}
+
+	std::size_t bytes(void) const {
+		std::size_t total = entries.capacity() * sizeof(Entry) + sparse.capacity() * sizeof(std::uint32_t)
+			+ buckets.capacity() * sizeof(buckets[0]) + wide.capacity() * sizeof(std::uint32_t);
+		for(const auto& bucket : buckets) total += bucket.capacity() * sizeof(std::uint32_t);
+		return total;
+	}
+
+	// Release spare capacity:
+	//     The table is halved while it has
+	//     more than twice the buckets it needs.
+	void shrink(void) {
+		while(!sparse.empty() && sparse.back() == vacant) sparse.pop_back();
+		std::size_t fitting = buckets.size();
+		while(fitting > 64 && fitting / 4 >= entries.size()) fitting /= 2;
+		if(fitting != buckets.size()) rehash(fitting);
+		entries.shrink_to_fit();
+		sparse.shrink_to_fit();
+		buckets.shrink_to_fit();
+		wide.shrink_to_fit();
+		for(auto& bucket : buckets) bucket.shrink_to_fit();
+		return;
+	}
+
+	// Call ifn on every entry whose cells meet the area
+	template<typename FN>
+	void visit(const Bounds& iarea, FN&& ifn) const {
+		if(entries.empty()) return;
+		const std::int32_t x0 = cell_of(iarea.min_x), y0 = cell_of(iarea.min_y);
+		const std::int32_t x1 = cell_of(iarea.max_x), y1 = cell_of(iarea.max_y);
+		if(x1 < x0 || y1 < y0) return;
+		auto meets = [&](const Entry& ientry) {
+			return ientry.x1 >= x0 && ientry.x0 <= x1 && ientry.y1 >= y0 && ientry.y0 <= y1;
+		};
+
+		// Areas wider than the table check every entry
+		if(spans(x0, y0, x1, y1)) {
+			for(const Entry& entry : entries) if(meets(entry)) ifn(entry);
+			return;
+		}
+		for(std::uint32_t slot : wide) if(meets(entries[sparse[slot]])) ifn(entries[sparse[slot]]);
+		for(std::int32_t y = y0; y <= y1; ++y)
+			for(std::int32_t x = x0; x <= x1; ++x)
+				for(std::uint32_t slot : buckets[bucket_of(x, y)]) {
+					const Entry& entry = entries[sparse[slot]];
+					if(x < entry.x0 || x > entry.x1 || y < entry.y0 || y > entry.y1) continue;
+					if(x != std::max(entry.x0, x0) || y != std::max(entry.y0, y0)) continue;
+					ifn(entry);
+				}
+		return;
+	}
+};
+
+// Event channel:
+//     Events of one type, queued by every
+//     thread on its own lane so parallel
+//     dispatches emit without locks, and the
+//     scripts listening to them.
+struct Channel {
+	virtual ~Channel(void) = default;
+
+	// Take the queued events as the next batch
+	virtual void swap(void) = 0;
+	// Hand the batch to every listener
+	virtual void deliver(World& iworld) = 0;
+	// Drop queued events and listeners,
+	// safe while delivering
+	virtual void clear(void) = 0;
+	// Bytes held and release of spare capacity
+	virtual std::size_t bytes(void) const = 0;
+	virtual void shrink(void) = 0;
+};
+
+template<typename E>
+struct Events final : Channel {
+	// Script of an object listening to the events:
+	//     The call finds the script and hands it
+	//     the batch, false once it is gone.
+	struct Listener {
+		ObjectID id;
+		std::size_t type;
+		bool (*call)(World&, ObjectID, std::span<const E>);
+	};
+
+	std::vector<std::vector<E>> lanes;
+	std::vector<E> batch;
+	std::vector<Listener> listeners;
+	std::size_t holes = 0;
+
+	explicit Events(std::size_t ilanes) : lanes(ilanes) { return; }
 
-		if(!deads.empty()) {
-			for(ObjectID id : kill_queue) objects.erase(id);
-			kill_queue.clear();
-			deads.clear();
+	// A single busy lane is swapped in whole
+	void swap(void) override {
+		batch.clear();
+		for(auto& queued : lanes) {
+			if(queued.empty()) continue;
+			if(batch.empty()) std::swap(batch, queued);
+			else batch.insert(batch.end(), std::make_move_iterator(queued.begin()), std::make_move_iterator(queued.end()));
+			queued.clear();
 		}
+		return;
+	}
+
+	// Listeners added while delivering
+	// wait for the next batch
+	void deliver(World& iworld) override {
+		const std::span<const E> events(batch);
+		const std::size_t count = events.empty() ? 0 : listeners.size();
+		for(std::size_t next = 0; next < count; ++next) {
+			const Listener listener = listeners[next];
+			if(listener.id == no_object) continue;
+			if(listener.call(iworld, listener.id, events)) continue;
+			if(listeners[next].id != no_object) ++holes;
+			listeners[next].id = no_object;
+		}
+		if(holes) {
+			std::erase_if(listeners, [](const Listener& ilistener) { return ilistener.id == no_object; });
+			holes = 0;
+		}
+		batch.clear();
+		return;
+	}
+
+	void clear(void) override {
+		for(auto& queued : lanes) queued.clear();
+		for(Listener& listener : listeners) listener.id = no_object;
+		holes = listeners.size();
+		return;
+	}
 
-		if(!actives.empty()) [[likely]]
-			for(auto& active : actives) if(auto ptr = active.lock())
-				(ptr.get()->*METHOD)(std::forward<ARGS>(iargs)...);
+	std::size_t bytes(void) const override {
+		std::size_t total = lanes.capacity() * sizeof(lanes[0]) + batch.capacity() * sizeof(E) + listeners.capacity() * sizeof(Listener);
+		for(const auto& queued : lanes) total += queued.capacity() * sizeof(E);
+		return total;
+	}
 
+	void shrink(void) override {
+		if(holes) {
+			std::erase_if(listeners, [](const Listener& ilistener) { return ilistener.id == no_object; });
+			holes = 0;
+		}
+		for(auto& queued : lanes) queued.shrink_to_fit();
+		batch.shrink_to_fit();
+		listeners.shrink_to_fit();
 		return;
 	}
 };
 
+// Registered serializer of a script or component type
+struct Serializer {
+	std::string name;
+	void (*save)(const Script&, Writer&) = nullptr;
+	bool (*read)(Script&, Reader&) = nullptr;
+	Script* (*load)(Object&, Reader&) = nullptr;
+	std::unique_ptr<Pool> (*pool)(void) = nullptr;
+};
+
+// Serializers by type identifier
+inline std::vector<Serializer>& serializers(void) {
+	static std::vector<Serializer> table;
+	return table;
+}
+
+// World memory:
+//     Pools objects and scripts by size and
+//     counts outstanding blocks, so the pools
+//     are only released when nothing points
+//     into them anymore. A weak_ptr may outlive
+//     the world, so an abandoned arena deletes
+//     itself once its last block is returned.
+//     An arena handed to another thread takes
+//     a lock, since blocks still referenced
+//     elsewhere come back from any thread.
+class Arena : public std::pmr::memory_resource {
+private:
+	std::pmr::unsynchronized_pool_resource pool;
+	std::size_t outstanding = 0;
+	bool abandoned = false;
+	bool scrapping = false;
+	bool shared = false;
+	std::mutex lock;
+
+	// Blocks returned in scrap mode
+	struct Block {
+		void* block;
+		std::size_t bytes;
+		std::size_t alignment;
+	};
+	std::vector<Block> scrapped;
+
+public:
+	explicit Arena(std::pmr::memory_resource* iupstream) : pool(iupstream) { return; }
+
+	// Deleter for the owning world
+	struct Abandon {
+		void operator()(Arena* iarena) const {
+			{
+				std::unique_lock guard = iarena->guard();
+				if(iarena->outstanding) {
+					iarena->abandoned = true;
+					return;
+				}
+			}
+			delete iarena;
+			return;
+		}
+	};
+
+	// Take the lock from now on:
+	//     Call before the arena is handed to
+	//     another thread.
+	void share(void) {
+		shared = true;
+		return;
+	}
+
+	// Memory resource the pools are built on
+	std::pmr::memory_resource* upstream(void) const { return pool.upstream_resource(); }
+
+	// Release the pools if every block was returned:
+	//     Otherwise blocks returned in scrap mode
+	//     go back on the free lists, so memory held
+	//     by a stale pointer never leaks the rest.
+	bool release(void) {
+		std::unique_lock hold = guard();
+		if(outstanding) {
+			for(const Block& scrap : scrapped) pool.deallocate(scrap.block, scrap.bytes, scrap.alignment);
+			scrapped.clear();
+			return false;
+		}
+		pool.release();
+		scrapped.clear();
+		return true;
+	}
+
+	// Scrap mode:
+	//     Returned blocks are only listed and
+	//     not put back on the free lists, since the
+	//     pools are about to be released anyway.
+	//     Arena::release() reclaims them either way.
+	void scrap(bool iscrapping) {
+		std::unique_lock hold = guard();
+		scrapping = iscrapping;
+		return;
+	}
+
+private:
+	// Lock of a shared arena, or none
+	std::unique_lock<std::mutex> guard(void) {
+		return shared ? std::unique_lock(lock) : std::unique_lock<std::mutex>();
+	}
+
+	void* do_allocate(std::size_t ibytes, std::size_t ialignment) override {
+		std::unique_lock hold = guard();
+		void* block = pool.allocate(ibytes, ialignment);
+		++outstanding;
+		return block;
+	}
+
+	void do_deallocate(void* iblock, std::size_t ibytes, std::size_t ialignment) override {
+		std::unique_lock hold = guard();
+		if(!scrapping) pool.deallocate(iblock, ibytes, ialignment);
+		else scrapped.emplace_back(Block{ iblock, ibytes, ialignment });
+		if(--outstanding || !abandoned) return;
+		if(hold) hold.unlock();
+		delete this;
+		return;
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& iother) const noexcept override {
+		return this == &iother;
+	}
+};
+
+} // namespace detail
+
+class Object : public std::enable_shared_from_this<Object> {
+	friend class World;
+	template<typename> friend class Ref;
+
+public:
+	// Script container
+	std::vector<std::shared_ptr<Script>> scripts;
+
+	// Object identifier
+	const ObjectID id;
+
+private:
+	// World the object lives in
+	World* home = nullptr;
+	// Object is in the world's kill queue
+	bool doomed = false;
+
+	// Ownership:
+	//     Killing an object kills
+	//     everything it owns.
+	ObjectID owner_id = no_object;
+	std::vector<ObjectID> owned_ids;
+
+	// Types of the attached components
+	std::vector<std::size_t> attached;
+
+	// Bumped whenever a script is taken,
+	// so script refs know they went stale
+	std::uint32_t revision = 0;
+
+	// Script type index:
+	//     Pairs of a script type identifier and
+	//     the script's position in the container,
+	//     sorted by type.
+	std::vector<std::pair<std::size_t, std::size_t>> index;
+
+public:
+	// Default constructor
+	Object(ObjectID iid) : id(iid) { return; }
+	// World constructor:
+	//     Objects created with World::create()
+	//     keep the world's dispatch list
+	//     up to date on grant and take.
+	Object(ObjectID iid, World* iworld) : id(iid), home(iworld) { return; }
+
+	Object(const Object&) = delete;
+	Object& operator=(const Object&) = delete;
+
+	// Default destructor:
+	//     Scripts held elsewhere lose their parent.
+	~Object(void) {
+		for(auto& script : scripts)
+			if(script && script.use_count() > 1) script->holder = nullptr;
+		return;
+	}
+
+	// World the object lives in, if any
+	World* world(void) const { return home; }
+
+	// Object that owns this one, or no_object
+	ObjectID owner(void) const { return owner_id; }
+	// Objects owned by this one
+	const std::vector<ObjectID>& owned(void) const { return owned_ids; }
+
+	// Scripts manipulations
+
+	// Reserve storage for scripts:
+	//     Objects granted many scripts
+	//     grow their containers only once.
+	void reserve(std::size_t icount) {
+		scripts.reserve(icount);
+		index.reserve(icount);
+		return;
+	}
+
+	// Find a script on the object and return iterator:
+	//     Scripts of exactly this type are found
+	//     through the type index. Otherwise the
+	//     first script derived from it is returned.
+	template<typename T>
+	auto find(void) {
+		if constexpr(std::is_base_of_v<Script, T>) {
+			if(const std::size_t position = locate(detail::type_of<T>()); position != std::size_t(-1))
+				return scripts.begin() + position;
+			if constexpr(std::is_final_v<T>) return scripts.end();
+		}
+		return std::find_if(scripts.begin(), scripts.end(),
+			[](const std::shared_ptr<Script>& iscript) {
+				return dynamic_cast<T*>(iscript.get()) != nullptr;
+			}
+		);
+	}
+
+	// Find a script on the object and return weak_ptr
+	template<typename T>
+	std::weak_ptr<T> seek(void) {
+		if constexpr(std::is_base_of_v<Script, T>) {
+			if(const std::size_t position = locate(detail::type_of<T>()); position != std::size_t(-1))
+				return std::static_pointer_cast<T>(scripts[position]);
+			if constexpr(std::is_final_v<T>) return std::weak_ptr<T>();
+		}
+		for(const auto& script : scripts)
+			if(auto casted = std::dynamic_pointer_cast<T>(script)) return casted;
+		return std::weak_ptr<T>();
+	}
+
+	// Find a script on the object and return a plain pointer:
+	//     Same as Object::seek() without
+	//     touching reference counts.
+	template<typename T>
+	T* peek(void) {
+		auto found = find<T>();
+		if(found == scripts.end()) return nullptr;
+		if constexpr(std::is_base_of_v<Script, T>) return static_cast<T*>(found->get());
+		else return dynamic_cast<T*>(found->get());
+	}
+
+	// Grant a script to the object:
+	//     If a script of this exact type has
+	//     already been provided to the object,
+	//     the method will return a
+	//     reference to it. Arguments passed
+	//     to the constructor will be ignored.
+	template<typename T, typename... ARGS>
+	std::weak_ptr<T> grant(ARGS&&... iargs);
+
+	// Take a script from the object
+	template<typename T>
+	bool take(void);
+
+	// Lightweight handle to a script on the object:
+	//     Never valid for objects made
+	//     outside of a world.
+	template<typename T>
+	Ref<T> ref(void);
+
+	// Update a script every few dispatches:
+	//     Same as World::pace() for the
+	//     script only.
+	template<typename T>
+	bool pace(std::size_t iinterval);
+
+	// Put every script of the object to sleep
+	void sleep(void) {
+		for(auto& script : scripts) if(script) script->sleep();
+		return;
+	}
+	// Wake every script of the object up
+	void wake(void) {
+		for(auto& script : scripts) if(script) script->wake();
+		return;
+	}
+
+	// Listen to events with a script:
+	//     Same as World::subscribe() for
+	//     this object.
+	template<typename E, typename T>
+	bool subscribe(void);
+	// Stop listening to events with a script
+	template<typename E, typename T>
+	bool unsubscribe(void);
+
+	// Put the object in the world's spatial index
+	// or move it, same as World::place()
+	bool place(const Bounds& ibounds);
+
+	// Components manipulations
+
+	// Attach a plain component to the object:
+	//     Same as World::attach() for this
+	//     object, nullptr outside of a world.
+	template<typename T, typename... ARGS>
+	T* attach(ARGS&&... iargs);
+
+	// Find a component on the object or nullptr
+	template<typename T>
+	T* component(void);
+
+	// Detach a component from the object
+	template<typename T>
+	bool detach(void);
+
+private:
+	// Put a new script on the object:
+	//     There must be no script of
+	//     exactly this type on it yet.
+	template<typename T>
+	void install(std::shared_ptr<T>&& iscript, const std::shared_ptr<Object>& iparent);
+
+	// Position of a script of exactly this type or -1
+	std::size_t locate(std::size_t itype) const {
+		auto found = std::lower_bound(index.begin(), index.end(), itype,
+			[](const std::pair<std::size_t, std::size_t>& ientry, std::size_t isought) {
+				return ientry.first < isought;
+			}
+		);
+		if(found == index.end() || found->first != itype) return -1;
+		return found->second;
+	}
+};
+
+class Objects {
+public:
+	// Object identifier and object pair
+	using value_type = std::pair<ObjectID, std::shared_ptr<Object>>;
+	using iterator = std::vector<value_type>::iterator;
+	using const_iterator = std::vector<value_type>::const_iterator;
+
+private:
+	// Sparse slot:
+	//     Position in the dense array and
+	//     generation of the identifier that
+	//     currently owns the slot.
+	struct Slot {
+		std::uint32_t dense;
+		std::uint32_t generation;
+	};
+
+	// Position of a vacant slot
+	static constexpr std::uint32_t vacant_slot = -1;
+
+	// Live objects, contiguous
+	std::vector<value_type> dense;
+	// Slots indexed by ObjectID
+	std::vector<Slot> slots;
+	// Slots ready to be reused
+	std::vector<std::uint32_t> vacants;
+
+public:
+	// Identifier parts
+	static constexpr std::uint32_t index_of(ObjectID iid) { return std::uint32_t(iid); }
+	static constexpr std::uint32_t generation_of(ObjectID iid) { return std::uint32_t(iid >> 32); }
+	static constexpr ObjectID compose(std::uint32_t iindex, std::uint32_t igeneration) {
+		return ObjectID(igeneration) << 32 | iindex;
+	}
+
+	// Iteration over live objects
+	iterator begin(void) { return dense.begin(); }
+	iterator end(void) { return dense.end(); }
+	const_iterator begin(void) const { return dense.begin(); }
+	const_iterator end(void) const { return dense.end(); }
+
+	std::size_t size(void) const { return dense.size(); }
+	std::size_t capacity(void) const { return dense.capacity(); }
+	bool empty(void) const { return dense.empty(); }
+
+	// Reserve storage for objects
+	void reserve(std::size_t icount) {
+		dense.reserve(icount);
+		slots.reserve(icount);
+		return;
+	}
+
+	// Find a live object
+	iterator find(ObjectID iid) {
+		const std::uint32_t index = index_of(iid);
+		if(index >= slots.size()) return dense.end();
+		const Slot& slot = slots[index];
+		if(slot.dense == vacant_slot || slot.generation != generation_of(iid)) return dense.end();
+		return dense.begin() + slot.dense;
+	}
+
+	bool contains(ObjectID iid) { return find(iid) != dense.end(); }
+
+	// Identifier the next emplaced object must have
+	ObjectID vacant(void) const {
+		if(vacants.empty()) return compose(std::uint32_t(slots.size()), 0);
+		return compose(vacants.back(), slots[vacants.back()].generation);
+	}
+
+	// Emplace an object created with Objects::vacant()
+	void emplace(std::shared_ptr<Object>&& iobject);
+
+	// Erase a live object:
+	//     The last object takes its place
+	//     and the slot's generation is bumped,
+	//     so the old identifier never resolves again.
+	void erase(iterator iwhere) {
+		const std::uint32_t index = index_of(iwhere->first);
+		if(iwhere != dense.end() - 1) {
+			*iwhere = std::move(dense.back());
+			slots[index_of(iwhere->first)].dense = std::uint32_t(iwhere - dense.begin());
+		}
+		dense.pop_back();
+		vacate(index);
+		return;
+	}
+
+	// Bytes of the object table
+	std::size_t bytes(void) const {
+		return dense.capacity() * sizeof(value_type) + slots.capacity() * sizeof(Slot) + vacants.capacity() * sizeof(std::uint32_t);
+	}
+
+	// Slots that ran out of generations
+	std::size_t retired(void) const {
+		return slots.size() - dense.size() - vacants.size();
+	}
+
+	// Sort live objects by slot:
+	//     Objects then come in the order their
+	//     slots were first taken, which is mostly
+	//     the order they were allocated in. Spare
+	//     capacity is released.
+	void compact(void) {
+		std::sort(dense.begin(), dense.end(), [](const value_type& ileft, const value_type& iright) {
+			return index_of(ileft.first) < index_of(iright.first);
+		});
+		for(std::size_t position = 0; position < dense.size(); ++position)
+			slots[index_of(dense[position].first)].dense = std::uint32_t(position);
+		dense.shrink_to_fit();
+		slots.shrink_to_fit();
+		vacants.shrink_to_fit();
+		return;
+	}
+
+	// Generations of every slot
+	std::vector<std::uint32_t> generations(void) const {
+		std::vector<std::uint32_t> saved(slots.size());
+		for(std::size_t index = 0; index < slots.size(); ++index) saved[index] = slots[index].generation;
+		return saved;
+	}
+
+	// Slots ready to be reused, last one first
+	const std::vector<std::uint32_t>& vacancies(void) const { return vacants; }
+
+	// Replace every object with loaded ones:
+	//     Slots get the saved generations and
+	//     vacancies, so identifiers that were
+	//     stale when they were saved stay stale
+	//     and new ones come in the same order.
+	//     Fails if an object does not match
+	//     its slot.
+	bool restore(std::vector<value_type>&& iobjects, const std::vector<std::uint32_t>& igenerations, const std::vector<std::uint32_t>& ivacancies) {
+		clear();
+		slots.clear();
+		for(std::uint32_t generation : igenerations) slots.emplace_back(Slot{ vacant_slot, generation });
+		for(auto& entry : iobjects) {
+			const std::uint32_t index = index_of(entry.first);
+			if(index >= slots.size() || slots[index].dense != vacant_slot
+				|| slots[index].generation != generation_of(entry.first) || slots[index].generation == std::uint32_t(-1)) {
+				clear();
+				return false;
+			}
+			slots[index].dense = std::uint32_t(dense.size());
+			dense.emplace_back(std::move(entry));
+		}
+
+		// Every usable vacant slot is listed once
+		std::size_t usable = 0;
+		for(const Slot& slot : slots) usable += slot.dense == vacant_slot && slot.generation != std::uint32_t(-1);
+		bool valid = ivacancies.size() == usable;
+		for(std::uint32_t index : ivacancies) {
+			if(!valid) break;
+			valid = index < slots.size() && slots[index].dense == vacant_slot && slots[index].generation != std::uint32_t(-1);
+			if(valid) slots[index].dense = vacant_slot - 1;
+		}
+		for(Slot& slot : slots) if(slot.dense == vacant_slot - 1) slot.dense = vacant_slot;
+		if(!valid) {
+			clear();
+			return false;
+		}
+		vacants = ivacancies;
+		return true;
+	}
+
+	// Erase every object
+	void clear(void) {
+		extract();
+		return;
+	}
+
+	// Erase every object and hand them over:
+	//     Generations are kept, so identifiers
+	//     of extracted objects never resolve again.
+	std::vector<value_type> extract(void) {
+		for(const auto& [objectid, object] : dense) {
+			Slot& slot = slots[index_of(objectid)];
+			slot.dense = vacant_slot;
+			++slot.generation;
+		}
+		std::vector<value_type> extracted = std::move(dense);
+		dense.clear();
+
+		// Lower slots are reused first
+		vacants.clear();
+		for(std::size_t index = slots.size(); index-- > 0;)
+			if(slots[index].generation != std::uint32_t(-1)) vacants.emplace_back(std::uint32_t(index));
+		return extracted;
+	}
+
+private:
+	// Free a slot:
+	//     Slots that ran out of
+	//     generations are retired.
+	void vacate(std::uint32_t iindex) {
+		Slot& slot = slots[iindex];
+		slot.dense = vacant_slot;
+		if(++slot.generation == std::uint32_t(-1)) return;
+		vacants.emplace_back(iindex);
+		return;
+	}
+};
+
+template<typename T>
+class Ref {
+	friend class Object;
+	friend class World;
+
+private:
+	World* home = nullptr;
+	ObjectID id = no_object;
+	std::uint32_t revision = 0;
+	std::uint32_t epoch = 0;
+	T* pointer = nullptr;
+
+	Ref(World* iworld, ObjectID iid, std::uint32_t irevision, T* ipointer);
+
+public:
+	// Default constructor, never valid
+	Ref(void) = default;
+
+	// The object is still in its world and,
+	// for scripts, none of its scripts was taken
+	bool valid(void) const;
+	explicit operator bool(void) const { return valid(); }
+
+	// Checked access, nullptr when stale
+	T* get(void) const { return valid() ? pointer : nullptr; }
+
+	// Unchecked access:
+	//     Check the ref with Ref::valid()
+	//     first, unless it was checked during
+	//     the same dispatch already.
+	T* operator->(void) const { return pointer; }
+	T& operator*(void) const { return *pointer; }
+
+	// Identifier of the object
+	ObjectID object(void) const { return id; }
+};
+
+class Jobs {
+private:
+	// Range of a parallel loop
+	struct Task {
+		void (*call)(const void*, std::size_t, std::size_t);
+		const void* context;
+		std::size_t begin;
+		std::size_t end;
+		std::atomic<std::size_t>* pending;
+	};
+
+	// Worker's own tasks:
+	//     The owner takes from the back,
+	//     thieves take from the front.
+	struct Queue {
+		std::mutex lock;
+		std::deque<Task> tasks;
+	};
+
+	const std::size_t count;
+	// Job system is Jobs::shared()
+	const bool common = false;
+	std::unique_ptr<Queue[]> queues;
+	std::vector<std::thread> workers;
+
+	// Sleeping workers wait for queued tasks
+	std::mutex sleep_lock;
+	std::condition_variable wake;
+	std::atomic<std::size_t> queued = 0;
+	std::atomic<std::size_t> turn = 0;
+	bool stopping = false;
+
+	// Worker index of this thread and its job
+	// system, 0 and nullptr for other threads
+	static inline thread_local std::size_t current = 0;
+	static inline thread_local const Jobs* owner = nullptr;
+
+	Jobs(std::size_t iworkers, bool icommon)
+		: count(iworkers), common(icommon), queues(new Queue[iworkers]) {
+		workers.reserve(iworkers);
+		for(std::size_t index = 0; index < iworkers; ++index)
+			workers.emplace_back(&Jobs::work, this, index);
+		return;
+	}
+
+public:
+	// Default constructor:
+	//     The calling thread helps with its own
+	//     loops, so one thread less is spawned.
+	explicit Jobs(std::size_t iworkers = fitting()) : Jobs(iworkers, false) { return; }
+
+	Jobs(const Jobs&) = delete;
+	Jobs& operator=(const Jobs&) = delete;
+
+	~Jobs(void) {
+		{
+			std::scoped_lock guard(sleep_lock);
+			stopping = true;
+		}
+		wake.notify_all();
+		for(auto& worker : workers) worker.join();
+		return;
+	}
+
+	// Process-wide job system
+	static Jobs& shared(void) {
+		static Jobs jobs(fitting(), true);
+		return jobs;
+	}
+
+	// Amount of worker threads
+	std::size_t size(void) const { return count; }
+
+	// Workers a default job system spawns
+	static std::size_t fitting(void) { return std::max(std::thread::hardware_concurrency(), 2u) - 1; }
+
+	// Index of the calling worker:
+	//     From 1 to Jobs::size() on workers of
+	//     Jobs::shared(), 0 on any other thread,
+	//     workers of other job systems included.
+	static std::size_t worker(void) { return owner && owner->common ? current : 0; }
+
+	// Run a parallel loop:
+	//     Splits [0, icount) into ranges of igrain,
+	//     or of a size picked for the amount if 0,
+	//     and calls ifn(begin, end) on them across
+	//     the workers and the calling thread.
+	//     Returns when every range is done.
+	template<typename FN>
+	void run(std::size_t icount, const FN& ifn, std::size_t igrain = 0) {
+		if(!icount) return;
+		const std::size_t grain = igrain ? igrain : std::max<std::size_t>(icount / ((size() + 1) * 4), 32);
+		if(!count || icount <= grain) {
+			ifn(std::size_t(0), icount);
+			return;
+		}
+
+		const std::size_t chunks = (icount + grain - 1) / grain;
+		std::atomic<std::size_t> pending = chunks;
+		for(std::size_t chunk = 0; chunk < chunks; ++chunk) {
+			Queue& queue = queues[turn.fetch_add(1, std::memory_order_relaxed) % size()];
+			std::scoped_lock guard(queue.lock);
+			queue.tasks.emplace_back(Task{
+				[](const void* icontext, std::size_t ibegin, std::size_t iend) {
+					(*static_cast<const FN*>(icontext))(ibegin, iend);
+					return;
+				},
+				&ifn, chunk * grain, std::min(icount, (chunk + 1) * grain), &pending
+			});
+		}
+		{
+			std::scoped_lock guard(sleep_lock);
+			queued.fetch_add(chunks);
+		}
+		wake.notify_all();
+
+		// Help instead of waiting
+		while(pending.load(std::memory_order_acquire)) {
+			Task task;
+			if(take(owner == this ? current - 1 : 0, task)) execute(task);
+			else std::this_thread::yield();
+		}
+		return;
+	}
+
+private:
+	// Take a task, own queue first
+	bool take(std::size_t iown, Task& otask) {
+		{
+			Queue& queue = queues[iown];
+			std::scoped_lock guard(queue.lock);
+			if(!queue.tasks.empty()) {
+				otask = queue.tasks.back();
+				queue.tasks.pop_back();
+				queued.fetch_sub(1);
+				return true;
+			}
+		}
+		for(std::size_t offset = 1; offset < size(); ++offset) {
+			Queue& queue = queues[(iown + offset) % size()];
+			std::scoped_lock guard(queue.lock);
+			if(!queue.tasks.empty()) {
+				otask = queue.tasks.front();
+				queue.tasks.pop_front();
+				queued.fetch_sub(1);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static void execute(Task& itask) {
+		itask.call(itask.context, itask.begin, itask.end);
+		itask.pending->fetch_sub(1, std::memory_order_release);
+		return;
+	}
+
+	// Worker loop
+	void work(std::size_t iindex) {
+		current = iindex + 1;
+		owner = this;
+		while(true) {
+			Task task;
+			if(take(iindex, task)) {
+				execute(task);
+				continue;
+			}
+			std::unique_lock guard(sleep_lock);
+			wake.wait(guard, [this](void) { return stopping || queued.load() > 0; });
+			if(stopping && !queued.load()) return;
+		}
+	}
+};
+
+#ifdef TUNA_PROFILE
+
+	// Profiling
+
+// Dispatch profile:
+//     Only compiled in with TUNA_PROFILE defined.
+//     Times are in nanoseconds of steady_clock.
+class Profile {
+public:
+	// Calls of one method on one script type
+	struct Sample {
+		std::uint64_t calls = 0;
+		std::uint64_t total = 0;
+		std::uint64_t max = 0;
+	};
+
+	// World activity
+	struct Counters {
+		std::uint64_t visited = 0;
+		std::uint64_t dispatched = 0;
+		std::uint64_t kills = 0;
+		std::uint64_t grants = 0;
+		std::uint64_t takes = 0;
+	};
+
+	// One dispatch call
+	struct Span {
+		const char* method;
+		std::uint64_t begin;
+		std::uint64_t end;
+		std::size_t thread;
+	};
+
+	// Method names by dispatch list index
+	static constexpr const char* methods[5] = { "loop", "step", "post", "drew", "other" };
+
+	// Script type names by type identifier
+	std::vector<const char*> names;
+	// Samples by type identifier and dispatch list index
+	std::vector<std::array<Sample, 5>> samples;
+
+	// Counters of this frame and of the frames before it
+	Counters frame;
+	Counters total;
+	// Dispatches of this frame
+	std::vector<Span> spans;
+
+public:
+	// Current time
+	static std::uint64_t now(void) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Start a new frame:
+	//     Adds this frame's counters to the totals
+	//     and forgets its spans. Call it once per frame,
+	//     after reading the frame's results.
+	void next(void) {
+		total.visited += frame.visited;
+		total.dispatched += frame.dispatched;
+		total.kills += frame.kills;
+		total.grants += frame.grants;
+		total.takes += frame.takes;
+		frame = Counters();
+		spans.clear();
+		return;
+	}
+
+	// Forget everything but the type names
+	void reset(void) {
+		for(auto& sample : samples) sample.fill(Sample());
+		frame = total = Counters();
+		spans.clear();
+		return;
+	}
+
+	// Visit every sample as (type name, method name, sample)
+	template<typename FN>
+	void each(FN&& ifn) const {
+		for(std::size_t type = 0; type < samples.size(); ++type)
+			for(std::size_t hook = 0; hook < std::size(methods); ++hook)
+				if(samples[type][hook].calls) ifn(names[type], methods[hook], samples[type][hook]);
+		return;
+	}
+
+	// This frame's dispatches in Chrome trace event format
+	std::string chrome_trace(void) const {
+		std::string trace = "{\"traceEvents\":[";
+		for(std::size_t i = 0; i < spans.size(); ++i) {
+			const Span& span = spans[i];
+			if(i) trace += ',';
+			trace += "{\"name\":\"";
+			trace += span.method;
+			trace += "\",\"ph\":\"X\",\"pid\":0,\"tid\":";
+			trace += std::to_string(span.thread);
+			trace += ",\"ts\":";
+			trace += std::to_string(span.begin / 1000.0);
+			trace += ",\"dur\":";
+			trace += std::to_string((span.end - span.begin) / 1000.0);
+			trace += '}';
+		}
+		trace += "]}";
+		return trace;
+	}
+
+	// Learn the name of a script type
+	void name(std::size_t itype, const char* iname) {
+		if(itype >= names.size()) {
+			names.resize(itype + 1, "");
+			samples.resize(itype + 1);
+		}
+		names[itype] = iname;
+		return;
+	}
+
+	// Record one call
+	void sample(std::size_t itype, std::size_t ihook, std::uint64_t itime) {
+		Sample& sample = samples[itype][ihook];
+		++sample.calls;
+		sample.total += itime;
+		sample.max = std::max(sample.max, itime);
+		return;
+	}
+};
+
+#endif
+
+class World {
+	friend class Script;
+	friend class Object;
+	friend struct Wait;
+	friend class Schedule;
+	template<typename> friend class Ref;
+
+public:
+	// Memory held by a world, in bytes:
+	//     Containers count their capacity,
+	//     objects and scripts their own size.
+	//     Allocator overhead is left out.
+	struct Memory {
+		// Scripts of one type
+		struct Kind {
+			std::size_t type;
+			// Registered name, empty if none
+			std::string name;
+			std::size_t count;
+			// Size of one script
+			std::size_t size;
+		};
+
+		// Objects, their table and their own lists
+		std::size_t objects = 0;
+		std::size_t scripts = 0;
+		// Dispatch lists and update tiers
+		std::size_t dispatch = 0;
+		std::size_t components = 0;
+		std::size_t spatial = 0;
+		std::size_t events = 0;
+		std::size_t tasks = 0;
+		// Kill queue, command buffers and scratch blob
+		std::size_t queues = 0;
+
+		// Object slots
+		std::size_t live = 0;
+		std::size_t vacant = 0;
+		std::size_t retired = 0;
+
+		// Script types by identifier, used ones only
+		std::vector<Kind> kinds;
+
+		std::size_t total(void) const {
+			return objects + scripts + dispatch + components + spatial + events + tasks + queues;
+		}
+	};
+
+private:
+	// Memory of objects and scripts:
+	//     Declared first, so it outlives them.
+	std::unique_ptr<detail::Arena, detail::Arena::Abandon> arena;
+
+public:
+	// Object container
+	Objects objects;
+
+private:
+	// Kill queue:
+	//     Objects are flagged as doomed when
+	//     queued, so no lookup is needed to
+	//     skip duplicates.
+	std::vector<ObjectID> kill_queue;
+
+	// Dispatch lists:
+	//     One per game loop method, holding only
+	//     the scripts that override it, plus one
+	//     with every script for other methods.
+	//     Taken scripts leave a hole that is
+	//     compacted later.
+	detail::Roster rosters[5];
+	// Same for scripts marked as Concurrent
+	detail::Roster concurrents[5];
+	// Dispatch lists of every script type,
+	// holding scripts of exactly that type
+	std::vector<detail::Roster> kinds;
+	// Update tiers, their game loop methods
+	// are kept out of the lists above
+	std::vector<detail::Tier> tiers;
+	// Buckets with changed dispatch lists, as
+	// tier and bucket indices
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> dirty;
+
+	// Grant sequence number
+	std::uint64_t serials = 0;
+	// Bumped by World::load():
+	//     Loaded objects get the saved slot
+	//     generations back, so refs taken before
+	//     would resolve to them otherwise.
+	std::uint32_t epoch = 0;
+	// Scripts every created object has room for
+	std::size_t script_capacity = 0;
+
+#ifdef TUNA_PROFILE
+	// Dispatch profile
+	Profile profiler;
+#endif
+
+	// Fixed timestep driver
+	float fixed_delta_time = 1.0f / 50.0f;
+	std::size_t max_steps = 8;
+	float accumulator = 0.0f;
+
+	// Scripts of killed objects, sorted by type
+	std::vector<std::shared_ptr<Script>> corpses;
+
+	// Kills may come from parallel dispatches,
+	// in which case their order is not known
+	std::mutex kill_lock;
+	bool parallel = false;
+	bool shuffled = false;
+
+	// Component pools:
+	//     Indexed by component type
+	//     identifier, created on first attach.
+	std::vector<std::unique_ptr<detail::Pool>> pools;
+
+	// Blob reused by World::clone()
+	std::vector<std::byte> scratch;
+
+	// Spatial index of placed objects, and the
+	// one World::restore() reads a blob's into
+	detail::Grid grid;
+	detail::Grid spare;
+
+	// Timer wheel of suspended tasks:
+	//     Slots by the fixed step they are due
+	//     on, so a step only looks at its own slot.
+	//     Tasks waiting for more steps than there
+	//     are slots come around again.
+	std::vector<std::coroutine_handle<Task::promise_type>> wheel[256];
+	// Slot being resumed
+	std::vector<std::coroutine_handle<Task::promise_type>> due;
+	// Fixed steps dispatched so far
+	std::uint64_t stepped = 0;
+	std::size_t suspended = 0;
+	bool awakening = false;
+
+	// Event channels:
+	//     Indexed by event type identifier,
+	//     created on first subscription.
+	std::vector<std::unique_ptr<detail::Channel>> channels;
+
+	// Dispatch depth:
+	//     While dispatching, structural changes
+	//     never touch the dispatch lists being
+	//     walked. Anything destroyed is kept alive
+	//     in the graveyard, and granted scripts wait
+	//     in the command buffer, until the outermost
+	//     World::dispatch() returns.
+	std::size_t dispatching = 0;
+	std::vector<std::shared_ptr<void>> graveyard;
+	std::vector<std::pair<Script*, unsigned>> pending;
+	std::vector<std::pair<Script*, std::size_t>> paces;
+
+public:
+	// Default constructor:
+	//     Objects and scripts are pooled
+	//     on top of the provided memory resource.
+	explicit World(std::pmr::memory_resource* iupstream = std::pmr::get_default_resource()) : arena(new detail::Arena(iupstream)) { return; }
+
+	// Objects keep a pointer to their world
+	World(const World&) = delete;
+	World& operator=(const World&) = delete;
+
+	// Default destructor:
+	//     Tears the world down like
+	//     World::clean(), so suspended tasks go
+	//     while their objects are still there
+	//     and script destructors find no world.
+	~World(void) {
+		clean();
+		return;
+	}
+
+	// Objects manipulations
+
+	// Clean the world:
+	//     Scripts are destroyed first, in reverse
+	//     grant order, object by object in storage
+	//     order. Pooled memory is then handed back
+	//     in bulk unless something still
+	//     references it.
+	void clean(void) {
+		std::vector<Objects::value_type> ruins = strip();
+		if(dispatching) {
+			for(auto& [objectid, object] : ruins) if(object) {
+				object->home = nullptr;
+				graveyard.emplace_back(std::move(object));
+			}
+			return;
+		}
+		raze(ruins, *arena);
+		return;
+	}
+
+	// Clean the world in the background:
+	//     With std::launch::async, the old objects and
+	//     their arena are handed to a thread that
+	//     destroys them, and the world may be filled
+	//     again right away. Script destructors then
+	//     run on that thread and must not touch the
+	//     world. The future is ready once they are
+	//     destroyed. Objects still referenced
+	//     elsewhere outlive it, and their memory is
+	//     freed when the last reference goes.
+	std::future<void> clean(std::launch ipolicy) {
+		if(dispatching || (ipolicy & std::launch::async) != std::launch::async) {
+			clean();
+			std::promise<void> done;
+			done.set_value();
+			return done.get_future();
+		}
+
+		std::vector<Objects::value_type> ruins = strip();
+		for(auto& [objectid, object] : ruins) if(object) object->home = nullptr;
+
+		std::unique_ptr<detail::Arena, detail::Arena::Abandon> old(new detail::Arena(arena->upstream()));
+		arena.swap(old);
+		old->share();
+
+		std::promise<void> done;
+		std::future<void> future = done.get_future();
+		std::thread([iruins = std::move(ruins), iarena = std::move(old), idone = std::move(done)](void) mutable {
+			raze(iruins, *iarena);
+			iarena.reset();
+			idone.set_value();
+			return;
+		}).detach();
+		return future;
+	}
+
+	// Reserve storage for objects and their scripts:
+	//     Room is made for iobjects objects in
+	//     the container and for iscripts scripts
+	//     on every object, including the ones
+	//     created later, and in the dispatch lists.
+	//     Like std::vector::reserve() it never
+	//     takes back room reserved before.
+	void reserve(std::size_t iobjects, std::size_t iscripts = 0) {
+		objects.reserve(iobjects);
+		script_capacity = std::max(script_capacity, iscripts);
+		if(!iscripts) return;
+		for(auto& [id, object] : objects) if(object) object->reserve(iscripts);
+		if(!dispatching) rosters[detail::every_hook].list.reserve(iobjects * iscripts);
+		return;
+	}
+
+	// Memory the world holds:
+	//     Walks every object, so it is
+	//     meant for occasional reports.
+	Memory memory_stats(void) const {
+		Memory memory;
+		const auto& table = detail::serializers();
+		std::vector<std::size_t> counts;
+
+		memory.objects = objects.bytes();
+		for(const auto& [id, object] : objects) {
+			if(!object) continue;
+			memory.objects += sizeof(Object) + object->scripts.capacity() * sizeof(std::shared_ptr<Script>)
+				+ object->owned_ids.capacity() * sizeof(ObjectID) + object->attached.capacity() * sizeof(std::size_t)
+				+ object->index.capacity() * sizeof(object->index[0]);
+			for(const auto& script : object->scripts) if(script) {
+				if(script->type >= counts.size()) counts.resize(script->type + 1);
+				++counts[script->type];
+			}
+		}
+		for(std::size_t type = 0; type < counts.size(); ++type) if(counts[type]) {
+			memory.kinds.emplace_back(Memory::Kind{ type, type < table.size() ? table[type].name : std::string(), counts[type], detail::size_of(type) });
+			memory.scripts += counts[type] * memory.kinds.back().size;
+		}
+
+		auto roster = [](const detail::Roster& iroster) { return iroster.list.capacity() * sizeof(Script*); };
+		for(std::size_t hook = 0; hook < std::size(rosters); ++hook) memory.dispatch += roster(rosters[hook]) + roster(concurrents[hook]);
+		memory.dispatch += kinds.capacity() * sizeof(detail::Roster) + tiers.capacity() * sizeof(detail::Tier);
+		for(const auto& kind : kinds) memory.dispatch += roster(kind);
+		for(const auto& tier : tiers) {
+			memory.dispatch += tier.buckets.capacity() * sizeof(detail::Bucket);
+			for(const auto& bucket : tier.buckets) for(const auto& list : bucket.rosters) memory.dispatch += roster(list);
+		}
+
+		memory.components = pools.capacity() * sizeof(pools[0]);
+		for(const auto& pool : pools) if(pool) memory.components += pool->bytes();
+		memory.spatial = grid.bytes() + spare.bytes();
+		memory.events = channels.capacity() * sizeof(channels[0]);
+		for(const auto& channel : channels) if(channel) memory.events += channel->bytes();
+		memory.tasks = due.capacity() * sizeof(due[0]);
+		for(const auto& slot : wheel) memory.tasks += slot.capacity() * sizeof(slot[0]);
+		memory.queues = kill_queue.capacity() * sizeof(ObjectID) + corpses.capacity() * sizeof(corpses[0])
+			+ graveyard.capacity() * sizeof(graveyard[0]) + pending.capacity() * sizeof(pending[0])
+			+ paces.capacity() * sizeof(paces[0]) + dirty.capacity() * sizeof(dirty[0]) + scratch.capacity();
+
+		memory.live = objects.size();
+		memory.vacant = objects.vacancies().size();
+		memory.retired = objects.retired();
+		return memory;
+	}
+
+	// Give memory back after a spike:
+	//     Removes killed objects, sorts objects
+	//     by slot, drops every hole from the
+	//     dispatch lists and releases the spare
+	//     capacity of every container, undoing
+	//     World::reserve(). Scripts stay where
+	//     they were allocated. Meant for loading
+	//     screens. Fails while dispatching.
+	bool compact(void) {
+		if(dispatching) return false;
+		sync();
+		objects.compact();
+		for(auto& [id, object] : objects) if(object) {
+			object->scripts.shrink_to_fit();
+			object->owned_ids.shrink_to_fit();
+			object->attached.shrink_to_fit();
+			object->index.shrink_to_fit();
+		}
+
+		for(std::size_t hook = 0; hook < std::size(rosters); ++hook) {
+			squeeze(rosters[hook], hook);
+			squeeze(concurrents[hook], hook);
+		}
+		for(auto& roster : kinds) squeeze(roster, detail::own_type);
+		for(auto& tier : tiers) for(auto& bucket : tier.buckets)
+			for(std::size_t hook = 0; hook < std::size(bucket.rosters); ++hook) squeeze(bucket.rosters[hook], hook);
+
+		for(auto& pool : pools) if(pool) pool->shrink();
+		grid.shrink();
+		spare = detail::Grid();
+		for(auto& channel : channels) if(channel) channel->shrink();
+		for(auto& slot : wheel) slot.shrink_to_fit();
+		due.shrink_to_fit();
+
+		kill_queue.shrink_to_fit();
+		corpses.shrink_to_fit();
+		graveyard.shrink_to_fit();
+		pending.shrink_to_fit();
+		paces.shrink_to_fit();
+		dirty.shrink_to_fit();
+		scratch = std::vector<std::byte>();
+		script_capacity = 0;
+		return true;
+	}
+
+	// Create an object in the world
+	std::weak_ptr<Object> create(void) {
+		std::shared_ptr<Object> object = std::allocate_shared<Object>(
+			std::pmr::polymorphic_allocator<Object>(arena.get()), objects.vacant(), this);
+		if(script_capacity) object->reserve(script_capacity);
+		std::weak_ptr<Object> ref(object);
+		objects.emplace(std::move(object));
+		return ref;
+	}
+
+	// Create an object from a prefab:
+	//     The object gets copies of the
+	//     prototypes, granted in order.
+	template<typename... SCRIPTS>
+	std::weak_ptr<Object> spawn(const Prefab<SCRIPTS...>& iprefab) {
+		std::shared_ptr<Object> object = instance(iprefab);
+		std::weak_ptr<Object> ref(object);
+		objects.emplace(std::move(object));
+		return ref;
+	}
+
+	// Create many objects from a prefab:
+	//     Storage of the objects, their scripts
+	//     and the dispatch lists is reserved once,
+	//     and the scripts are granted without
+	//     looking for duplicates. Identifiers of
+	//     the objects are appended to oids.
+	template<typename... SCRIPTS>
+	void spawn(const Prefab<SCRIPTS...>& iprefab, std::size_t icount, std::vector<ObjectID>& oids) {
+		if(objects.capacity() - objects.size() < icount) objects.reserve(std::max(objects.size() + icount, objects.size() * 2));
+		detail::grow(oids, icount);
+		if(!dispatching) (make_room<SCRIPTS>(icount), ...);
+		for(std::size_t next = 0; next < icount; ++next) {
+			std::shared_ptr<Object> object = instance(iprefab);
+			oids.emplace_back(object->id);
+			objects.emplace(std::move(object));
+		}
+		return;
+	}
+
+	// Find the object in the world
+	std::weak_ptr<Object> seek(ObjectID iid) {
+		auto found = objects.find(iid);
+		if(found == objects.end())
+			return std::weak_ptr<Object>();
+		return std::weak_ptr<Object>(found->second);
+	}
+
+	// Find the object in the world and return a plain pointer:
+	//     Same as World::seek() without
+	//     touching reference counts.
+	Object* peek(ObjectID iid) {
+		auto found = objects.find(iid);
+		if(found == objects.end()) return nullptr;
+		return found->second.get();
+	}
+
+	// Lightweight handle to the object in the world
+	Ref<Object> ref(ObjectID iid) {
+		auto found = objects.find(iid);
+		if(found == objects.end() || !found->second) return Ref<Object>();
+		return Ref<Object>(this, iid, 0, found->second.get());
+	}
+
+	// Kill the object in the world:
+	//     Despite its name, this method
+	//     does not kill the object
+	//     immediately. Instead, the object is
+	//     added to the kill queue
+	//     and will only be removed
+	//     by World::flush_kills(), which runs
+	//     on the next call to World::dispatch().
+	//     Safe to call from parallel dispatches.
+	//     Everything the object owns is
+	//     killed along with it.
+	bool kill(ObjectID iid) {
+		auto found = objects.find(iid);
+		if(found == objects.end() || !found->second) return false;
+		if(parallel) {
+			std::scoped_lock guard(kill_lock);
+			doom(*found->second);
+			shuffled = true;
+		}
+		else doom(*found->second);
+		return true;
+	}
+
+	// Kill a batch of objects in the world:
+	//     Same as killing them one by one.
+	//     Returns the amount of objects found.
+	std::size_t kill(std::span<const ObjectID> iids) {
+		std::unique_lock guard(kill_lock, std::defer_lock);
+		if(parallel) {
+			guard.lock();
+			shuffled = true;
+		}
+
+		std::size_t found_count = 0;
+		for(ObjectID id : iids) {
+			auto found = objects.find(id);
+			if(found == objects.end() || !found->second) continue;
+			doom(*found->second);
+			++found_count;
+		}
+		return found_count;
+	}
+
+	// Make one object own another:
+	//     An object has one owner at most, so
+	//     the owned one leaves its old owner.
+	//     Fails on missing or killed objects
+	//     and on ownership cycles.
+	bool own(ObjectID iowner, ObjectID iowned) {
+		Object* owner = alive(iowner);
+		Object* owned = alive(iowned);
+		if(!owner || !owned || owner == owned) return false;
+		for(ObjectID up = owner->owner_id; up != no_object;) {
+			if(up == iowned) return false;
+			Object* next = alive(up);
+			up = next ? next->owner_id : no_object;
+		}
+
+		disown(iowned);
+		owned->owner_id = iowner;
+		owner->owned_ids.emplace_back(iowned);
+		return true;
+	}
+
+	// Release an object from its owner
+	bool disown(ObjectID iowned) {
+		Object* owned = alive(iowned);
+		if(!owned || owned->owner_id == no_object) return false;
+		if(Object* owner = alive(owned->owner_id))
+			std::erase(owner->owned_ids, iowned);
+		owned->owner_id = no_object;
+		return true;
+	}
+
+	// Components manipulations
+
+	// Attach a plain component to the object:
+	//     Components are not scripts. They get no
+	//     calls and live in a contiguous pool per
+	//     type, walked with World::each(). If the
+	//     object already has one of this type, it
+	//     is returned and arguments are ignored.
+	//     Pointers to components of a type stay
+	//     valid until one is attached or detached.
+	template<typename T, typename... ARGS>
+	T* attach(ObjectID iid, ARGS&&... iargs) {
+		static_assert(!std::is_base_of_v<Script, T>, "Scripts are granted, not attached");
+		Object* object = alive(iid);
+		if(!object) return nullptr;
+
+		detail::Components<T>& pool = pool_of<T>();
+		if(T* found = pool.find(iid)) return found;
+		object->attached.emplace_back(detail::type_of<T>());
+		return &pool.emplace(iid, std::forward<ARGS>(iargs)...);
+	}
+
+	// Find a component on the object or nullptr
+	template<typename T>
+	T* component(ObjectID iid) {
+		detail::Components<T>* pool = pool_if<T>();
+		return pool ? pool->find(iid) : nullptr;
+	}
+
+	// Detach a component from the object
+	template<typename T>
+	bool detach(ObjectID iid) {
+		detail::Components<T>* pool = pool_if<T>();
+		if(!pool || !pool->find(iid)) return false;
+		pool->erase(iid);
+		std::erase(objects.find(iid)->second->attached, detail::type_of<T>());
+		return true;
+	}
+
+	// Call a function on every object with these components:
+	//     The pool of the first type is walked in
+	//     order and the others are looked up, so
+	//     put the rarest component first. The
+	//     function takes references to the
+	//     components, optionally after the
+	//     object's identifier. Components must
+	//     not be attached or detached meanwhile.
+	template<typename T, typename... TS, typename FN>
+	void each(FN&& ifn) {
+		detail::Components<T>* first = pool_if<T>();
+		if(!first) return;
+
+		auto rest = std::make_tuple(pool_if<TS>()...);
+		std::apply([&](auto*... ipools) {
+			if(!(true && ... && ipools)) return;
+
+			T* data = first->data.data();
+			const ObjectID* owners = first->owners.data();
+			const std::size_t count = first->data.size();
+			auto visit = [&](ObjectID iid, T& icomponent, auto*... ifound) {
+				if(!(true && ... && ifound)) return;
+				if constexpr(std::is_invocable_v<FN&, ObjectID, T&, TS&...>) ifn(iid, icomponent, *ifound...);
+				else ifn(icomponent, *ifound...);
+				return;
+			};
+			for(std::size_t i = 0; i < count; ++i)
+				visit(owners[i], data[i], ipools->find(owners[i])...);
+			return;
+		}, rest);
+		return;
+	}
+
+	// Spatial queries
+
+	// Set the cell size of the spatial index:
+	//     Cells about the size of a typical query
+	//     work best. Placed objects are kept.
+	void partition(const float CELL_SIZE) {
+		grid.cell = CELL_SIZE > 0.0f ? CELL_SIZE : 1.0f;
+		for(auto& entry : grid.entries) {
+			entry.x0 = grid.cell_of(entry.bounds.min_x);
+			entry.y0 = grid.cell_of(entry.bounds.min_y);
+			entry.x1 = grid.cell_of(entry.bounds.max_x);
+			entry.y1 = grid.cell_of(entry.bounds.max_y);
+		}
+		grid.rehash(grid.buckets.size());
+		return;
+	}
+
+	// Put an object in the spatial index or move it:
+	//     Call it whenever the object moves, for
+	//     instance from Script::post. Moves within
+	//     the same cells only overwrite the bounds.
+	//     Not safe from parallel dispatches.
+	bool place(ObjectID iid, const Bounds& ibounds) {
+		if(!alive(iid)) return false;
+		grid.place(iid, ibounds);
+		return true;
+	}
+
+	// Take an object out of the spatial index:
+	//     Killed objects leave it by themselves.
+	bool displace(ObjectID iid) { return grid.erase(iid); }
+
+	// Bounds of a placed object or nullptr
+	const Bounds* bounds(ObjectID iid) const {
+		const std::uint32_t position = grid.locate(iid);
+		return position == detail::Grid::vacant ? nullptr : &grid.entries[position].bounds;
+	}
+
+	// Find placed objects overlapping an area:
+	//     Identifiers are appended to oids, in
+	//     no particular order. Queries change
+	//     nothing, so scripts may run them from
+	//     parallel dispatches while nothing is placed.
+	void query_aabb(const Bounds& iarea, std::vector<ObjectID>& oids) const {
+		grid.visit(iarea, [&](const detail::Grid::Entry& ientry) {
+			const Bounds& bounds = ientry.bounds;
+			if(bounds.max_x >= iarea.min_x && bounds.min_x <= iarea.max_x
+				&& bounds.max_y >= iarea.min_y && bounds.min_y <= iarea.max_y) oids.emplace_back(ientry.id);
+			return;
+		});
+		return;
+	}
+
+	// Find placed objects within a distance of a point:
+	//     Same as World::query_aabb() for the
+	//     bounds closer than iradius.
+	void query_radius(float ix, float iy, float iradius, std::vector<ObjectID>& oids) const {
+		const float square = iradius * iradius;
+		grid.visit(Bounds{ ix - iradius, iy - iradius, ix + iradius, iy + iradius }, [&](const detail::Grid::Entry& ientry) {
+			const Bounds& bounds = ientry.bounds;
+			const float dx = std::max({ bounds.min_x - ix, 0.0f, ix - bounds.max_x });
+			const float dy = std::max({ bounds.min_y - iy, 0.0f, iy - bounds.max_y });
+			if(dx * dx + dy * dy <= square) oids.emplace_back(ientry.id);
+			return;
+		});
+		return;
+	}
+
+	// Remove the objects in the kill queue:
+	//     Takes time in proportion to the killed
+	//     objects and their scripts only. Runs by
+	//     itself before every outermost dispatch,
+	//     call it earlier to have killed objects
+	//     gone right away. Does nothing while
+	//     dispatching. Returns the amount of
+	//     removed objects.
+	std::size_t flush_kills(void) {
+		if(dispatching || kill_queue.empty()) return 0;
+
+		// Kills from parallel dispatches go in identifier
+		// order, so freed slots are reused the same way
+		// whatever order they came in
+		if(shuffled) std::sort(kill_queue.begin(), kill_queue.end());
+		shuffled = false;
+
+		std::size_t removed = 0;
+		for(ObjectID id : kill_queue) {
+			auto found = objects.find(id);
+			if(found == objects.end()) continue;
+			if(auto& object = found->second) {
+				for(auto& script : object->scripts) if(script) delist(script.get());
+				if(Object* owner = alive(object->owner_id); owner && !owner->doomed)
+					std::erase(owner->owned_ids, id);
+				object->owner_id = no_object;
+				object->owned_ids.clear();
+				for(std::size_t type : object->attached) pools[type]->erase(id);
+				object->attached.clear();
+				grid.erase(id);
+				object->home = nullptr;
+				object->doomed = false;
+
+				// Objects held elsewhere keep their scripts
+				if(object.use_count() == 1) {
+					for(auto& script : object->scripts) {
+						if(!script) continue;
+						script->holder = nullptr;
+						corpses.emplace_back(std::move(script));
+					}
+					object->scripts.clear();
+					object->index.clear();
+				}
+			}
+			objects.erase(found);
+			++removed;
+		}
+		kill_queue.clear();
+
+		// Scripts of one type are destroyed together
+		std::stable_sort(corpses.begin(), corpses.end(),
+			[](const std::shared_ptr<Script>& ileft, const std::shared_ptr<Script>& iright) {
+				return ileft->type < iright->type;
+			}
+		);
+		corpses.clear();
+
+#ifdef TUNA_PROFILE
+		profiler.frame.kills += removed;
+#endif
+		return removed;
+	}
+
+	// Call a method on every object's script in the world:
+	//     Scripts are called in their type's
+	//     Script::order, then in grant order.
+	//     Paced scripts are called after the
+	//     rest, when their bucket is due.
+	template<auto METHOD, typename... ARGS>
+	void dispatch(ARGS&&... iargs) {
+		constexpr std::size_t HOOK = detail::hook_of<METHOD>;
+		sync();
+#ifdef TUNA_PROFILE
+		const std::uint64_t begin = Profile::now();
+#endif
+
+		++dispatching;
+		if(concurrents[HOOK].list.empty()) [[likely]]
+			sweep<METHOD>(rosters[HOOK], iargs...);
+		else merge<METHOD>(rosters[HOOK], concurrents[HOOK], iargs...);
+		if constexpr(HOOK != detail::every_hook) if(!tiers.empty()) pulse<METHOD>(iargs...);
+		if constexpr(HOOK == detail::hook_of<&Script::step>) awaken();
+		if(--dispatching == 0) settle();
+
+#ifdef TUNA_PROFILE
+		profiler.spans.emplace_back(Profile::Span{ Profile::methods[HOOK], begin, Profile::now(), Jobs::worker() });
+#endif
+		return;
+	}
+
+	// Call a method on every object's script in the world, in parallel:
+	//     Scripts marked as Concurrent are split
+	//     across the shared job system, after the
+	//     rest run on the calling thread. While they
+	//     run, scripts may only call World::kill()
+	//     on the world, and every call gets the same
+	//     arguments.
+	template<auto METHOD, typename... ARGS>
+	void dispatch_parallel(ARGS&&... iargs) {
+		constexpr std::size_t HOOK = detail::hook_of<METHOD>;
+		sync();
+#ifdef TUNA_PROFILE
+		const std::uint64_t begin = Profile::now();
+		profiler.frame.visited += concurrents[HOOK].list.size();
+		profiler.frame.dispatched += concurrents[HOOK].list.size() - concurrents[HOOK].holes;
+#endif
+
+		++dispatching;
+		sweep<METHOD>(rosters[HOOK], std::forward<ARGS>(iargs)...);
+
+		Script* const* list = concurrents[HOOK].list.data();
+		parallel = true;
+		Jobs::shared().run(concurrents[HOOK].list.size(), [&](std::size_t ibegin, std::size_t iend) {
+			for(std::size_t i = ibegin; i < iend; ++i) if(Script* script = list[i]) [[likely]]
+				(script->*METHOD)(iargs...);
+			return;
+		});
+		parallel = false;
+
+		if constexpr(HOOK != detail::every_hook) if(!tiers.empty()) pulse<METHOD>(iargs...);
+		if constexpr(HOOK == detail::hook_of<&Script::step>) awaken();
+		if(--dispatching == 0) settle();
+
+#ifdef TUNA_PROFILE
+		profiler.spans.emplace_back(Profile::Span{ Profile::methods[HOOK], begin, Profile::now(), Jobs::worker() });
+#endif
+		return;
+	}
+
+	// Call a method on every script of exactly type T:
+	//     Only the dispatch list of the type is
+	//     walked, in grant order. Game loop
+	//     methods are called directly instead of
+	//     through the virtual table. Scripts
+	//     derived from T are not visited.
+	template<typename T, auto METHOD, typename... ARGS>
+	void dispatch(ARGS&&... iargs) {
+		static_assert(std::is_base_of_v<Script, T>, "Only scripts are dispatched");
+		sync();
+		const std::size_t type = detail::type_of<T>();
+		if(type >= kinds.size()) return;
+#ifdef TUNA_PROFILE
+		const std::uint64_t begin = Profile::now();
+		profiler.frame.visited += kinds[type].list.size();
+#endif
+
+		++dispatching;
+		for(Script* script : kinds[type].list) if(script) [[likely]]
+			call<METHOD, T>(script, std::forward<ARGS>(iargs)...);
+		if(--dispatching == 0) settle();
+
+#ifdef TUNA_PROFILE
+		profiler.spans.emplace_back(Profile::Span{ Profile::methods[detail::own_hook_of<T, METHOD>], begin, Profile::now(), Jobs::worker() });
+#endif
+		return;
+	}
+
+	// Run every phase of a schedule:
+	//     Waves of the schedule run in order,
+	//     and the phases of one wave in parallel
+	//     on the shared job system. A phase alone
+	//     in its wave is the same as its dispatch.
+	//     Phases sharing a wave may only call
+	//     World::kill() on the world.
+	void run(const Schedule& ischedule, const float DELTA_TIME);
+
+#ifdef TUNA_PROFILE
+	// Dispatch profile:
+	//     Per script type and method, plus
+	//     per frame counters. Calls made by
+	//     parallel dispatches only count
+	//     towards their dispatch's span.
+	Profile& profile(void) { return profiler; }
+	const Profile& profile(void) const { return profiler; }
+#endif
+
+	// Tasks
+
+	// Start a coroutine owned by an object:
+	//     It runs until its first co_await right
+	//     away, then is resumed on the fixed step
+	//     it waits for, after the step's scripts.
+	//     Once the object is gone, it is destroyed
+	//     instead. Tasks are not saved. Not safe
+	//     from parallel dispatches.
+	bool start(ObjectID iid, Task&& itask) {
+		if(!alive(iid) || !itask.handle) return false;
+		launch(std::exchange(itask.handle, nullptr), iid, std::size_t(-1), 0);
+		return true;
+	}
+
+	// Amount of suspended tasks
+	std::size_t tasks(void) const { return suspended; }
+
+	// Events
+
+	// Queue an event:
+	//     It is delivered by the next
+	//     World::deliver(). Events of a type
+	//     nobody listens to are dropped. Safe
+	//     from parallel dispatches, every thread
+	//     queues on its own lane.
+	template<typename E, typename... ARGS>
+	void emit(ARGS&&... iargs) {
+		const std::size_t type = detail::type_of<E>();
+		if(type >= channels.size() || !channels[type]) return;
+		auto& events = static_cast<detail::Events<E>&>(*channels[type]);
+		events.lanes[std::min(Jobs::worker(), events.lanes.size() - 1)].emplace_back(std::forward<ARGS>(iargs)...);
+		return;
+	}
+
+	// Listen to events with a script:
+	//     Script T of the object gets every
+	//     delivered event through its
+	//     receive(const E&) method. The
+	//     subscription ends with the script.
+	template<typename E, typename T>
+	bool subscribe(ObjectID iid) {
+		static_assert(requires(T& iscript, const E& ievent) { iscript.receive(ievent); }, "Listeners need receive(const E&)");
+		Object* object = alive(iid);
+		if(!object || !object->peek<T>()) return false;
+
+		const std::size_t type = detail::type_of<E>();
+		if(type >= channels.size()) channels.resize(type + 1);
+		if(!channels[type]) channels[type] = std::make_unique<detail::Events<E>>(Jobs::fitting() + 1);
+		auto& events = static_cast<detail::Events<E>&>(*channels[type]);
+		for(const auto& listener : events.listeners)
+			if(listener.id == iid && listener.type == detail::type_of<T>()) return true;
+		events.listeners.emplace_back(typename detail::Events<E>::Listener{ iid, detail::type_of<T>(),
+			[](World& iworld, ObjectID ilistener, std::span<const E> ibatch) {
+				Object* found = iworld.alive(ilistener);
+				T* script = found ? found->peek<T>() : nullptr;
+				if(!script) return false;
+				for(const E& event : ibatch) script->receive(event);
+				return true;
+			}
+		});
+		return true;
+	}
+
+	// Stop listening to events with a script
+	template<typename E, typename T>
+	bool unsubscribe(ObjectID iid) {
+		const std::size_t type = detail::type_of<E>();
+		if(type >= channels.size() || !channels[type]) return false;
+		auto& events = static_cast<detail::Events<E>&>(*channels[type]);
+		for(auto& listener : events.listeners) if(listener.id == iid && listener.type == detail::type_of<T>()) {
+			listener.id = no_object;
+			++events.holes;
+			return true;
+		}
+		return false;
+	}
+
+	// Deliver every queued event:
+	//     Events are batched per type, and each
+	//     listener gets the whole batch in a row,
+	//     in emit order per thread. Events
+	//     emitted meanwhile wait for the next
+	//     call. Changes to the world are deferred
+	//     like in World::dispatch().
+	void deliver(void) {
+		if(dispatching) return;
+		sync();
+		for(auto& channel : channels) if(channel) channel->swap();
+
+		++dispatching;
+		const std::size_t count = channels.size();
+		for(std::size_t type = 0; type < count; ++type) if(channels[type]) channels[type]->deliver(*this);
+		if(--dispatching == 0) settle();
+		return;
+	}
+
+	// Serialization
+
+	// Write the world to a blob:
+	//     Appends to oblob. Kills are flushed
+	//     first. Objects keep their identifiers,
+	//     ownership and component types and
+	//     scripts registered with
+	//     tuna::serializable(), the rest is left
+	//     out. Vacant slots, grant serials, update
+	//     tiers and the fixed timestep are written
+	//     too, so a loaded world goes on the same
+	//     way, in the same dispatch order.
+	//     Fails while dispatching.
+	bool save(std::vector<std::byte>& oblob) {
+		if(dispatching) return false;
+		flush_kills();
+
+		Writer writer(oblob);
+		writer.write(blob_magic);
+		writer.write(blob_version);
+
+		// Registered types, by their position in the blob
+		const auto& table = detail::serializers();
+		std::vector<std::uint32_t> local(table.size(), std::uint32_t(-1));
+		std::uint32_t named = 0;
+		for(std::size_t type = 0; type < table.size(); ++type) if(!table[type].name.empty()) local[type] = named++;
+		writer.write(named);
+		for(const auto& entry : table) if(!entry.name.empty()) writer.text(entry.name);
+
+		writer.write(fixed_delta_time);
+		writer.write(std::uint64_t(max_steps));
+		writer.write(accumulator);
+		writer.write(serials);
+
+		const std::vector<std::uint32_t> generations = objects.generations();
+		writer.write(std::uint64_t(generations.size()));
+		writer.write(generations.data(), generations.size() * sizeof(std::uint32_t));
+		const std::vector<std::uint32_t>& vacancies = objects.vacancies();
+		writer.write(std::uint64_t(vacancies.size()));
+		writer.write(vacancies.data(), vacancies.size() * sizeof(std::uint32_t));
+
+		writer.write(std::uint32_t(tiers.size()));
+		for(const auto& tier : tiers) {
+			writer.write(std::uint64_t(tier.interval));
+			for(std::size_t turn : tier.turns) writer.write(std::uint64_t(turn));
+			for(const auto& bucket : tier.buckets) {
+				float elapsed[4];
+				for(std::size_t hook = 0; hook < std::size(elapsed); ++hook)
+					elapsed[hook] = float(tier.totals[hook] - bucket.marks[hook]);
+				writer.write(elapsed);
+			}
+		}
+
+		writer.write(std::uint64_t(objects.size()));
+		for(const auto& [id, object] : objects) {
+			writer.write(id);
+			writer.write(object->owner_id);
+			writer.write(std::uint32_t(object->owned_ids.size()));
+			writer.write(object->owned_ids.data(), object->owned_ids.size() * sizeof(ObjectID));
+
+			const std::size_t count_at = writer.size();
+			std::uint32_t count = 0;
+			writer.write(count);
+			for(const auto& script : object->scripts) {
+				if(!script || script->type >= table.size() || !table[script->type].save) continue;
+				writer.write(local[script->type]);
+				writer.write(std::uint8_t(script->asleep));
+				writer.write(std::uint32_t(script->tier ? tiers[script->tier - 1].interval : 1));
+				writer.write(script->bucket);
+				writer.write(script->serial);
+				float since[4] = {};
+				if(script->tier) for(std::size_t hook = 0; hook < std::size(since); ++hook)
+					since[hook] = float(tiers[script->tier - 1].totals[hook] - script->joined[hook]);
+				writer.write(since);
+				const std::size_t size_at = writer.size();
+				writer.write(std::uint64_t(0));
+				table[script->type].save(*script, writer);
+				writer.patch(size_at, std::uint64_t(writer.size() - size_at - sizeof(std::uint64_t)));
+				++count;
+			}
+			writer.patch(count_at, count);
+		}
+
+		const std::size_t count_at = writer.size();
+		std::uint32_t count = 0;
+		writer.write(count);
+		for(std::size_t type = 0; type < pools.size() && type < table.size(); ++type) {
+			if(!pools[type] || !table[type].pool) continue;
+			writer.write(local[type]);
+			writer.write(std::uint64_t(pools[type]->owners.size()));
+			const std::size_t size_at = writer.size();
+			writer.write(std::uint64_t(0));
+			pools[type]->save(writer);
+			writer.patch(size_at, std::uint64_t(writer.size() - size_at - sizeof(std::uint64_t)));
+			++count;
+		}
+		writer.patch(count_at, count);
+
+		grid.save(writer);
+		return true;
+	}
+
+	// Replace the world with one from a blob:
+	//     The world is cleaned first and memory
+	//     is reserved in bulk. Types that are not
+	//     registered in this program are skipped.
+	//     On a malformed blob the world is left
+	//     clean and false is returned. The blob
+	//     is only read, so it may be a
+	//     memory-mapped file.
+	bool load(std::span<const std::byte> iblob) {
+		if(dispatching) return false;
+		clean();
+		++epoch;
+		if(!read(iblob, Pass::load)) {
+			clean();
+			return false;
+		}
+		return true;
+	}
+
+	// Bring the world back to the state of a blob:
+	//     Same as World::load(), but if the world
+	//     still has the same objects with the same
+	//     saved scripts and components, their
+	//     state is read back in place, with no
+	//     objects or scripts made or destroyed.
+	//     That is the usual case for rollback.
+	bool restore(std::span<const std::byte> iblob) {
+		if(dispatching) return false;
+		flush_kills();
+		if(read(iblob, Pass::check) && read(iblob, Pass::reread)) return true;
+		return load(iblob);
+	}
+
+	// Copy the world into another one:
+	//     What World::save() writes is copied,
+	//     in place if the other world matches.
+	bool clone(World& otarget) {
+		if(&otarget == this) return false;
+		scratch.clear();
+		return save(scratch) && otarget.restore(scratch);
+	}
+
+	// Game loop driver
+
+	// Update the object's scripts every few dispatches:
+	//     Game loop methods of its scripts are
+	//     only called on every iinterval-th
+	//     dispatch of the method, with the time
+	//     passed since the last call. Paced
+	//     scripts of one interval are spread
+	//     over the dispatches evenly, and run
+	//     on the calling thread. An interval of
+	//     0 or 1 updates them every dispatch,
+	//     intervals above 65536 are clamped.
+	bool pace(ObjectID iid, std::size_t iinterval) {
+		Object* object = alive(iid);
+		if(!object) return false;
+		for(auto& script : object->scripts) if(script) pace(script.get(), iinterval);
+		return true;
+	}
+
+	// Set up the fixed timestep:
+	//     World::tick() runs at most imax_steps
+	//     fixed steps per call and drops the
+	//     time it could not catch up with.
+	//     Returns false and keeps the old step
+	//     if the new one is not a positive and
+	//     finite amount of time.
+	bool timestep(const float FIXED_DELTA_TIME, std::size_t imax_steps = 8) {
+		if(!(FIXED_DELTA_TIME > 0.0f) || !std::isfinite(FIXED_DELTA_TIME)) return false;
+		fixed_delta_time = FIXED_DELTA_TIME;
+		max_steps = std::max<std::size_t>(imax_steps, 1);
+		accumulator = 0.0f;
+		return true;
+	}
+
+	// Run fixed steps for the real time that passed:
+	//     Dispatches Script::step as many times as
+	//     the accumulated time allows, up to the
+	//     catch-up limit, so one slow frame never
+	//     snowballs. Returns the amount of steps.
+	//     Negative and non-finite time is ignored.
+	std::size_t tick(const float REAL_DELTA_TIME) {
+		if(!(REAL_DELTA_TIME >= 0.0f) || !std::isfinite(REAL_DELTA_TIME)) return 0;
+		accumulator += REAL_DELTA_TIME;
+
+		std::size_t steps = 0;
+		while(accumulator >= fixed_delta_time && steps < max_steps) {
+			dispatch<&Script::step>(fixed_delta_time);
+			accumulator -= fixed_delta_time;
+			++steps;
+		}
+		if(accumulator >= fixed_delta_time)
+			accumulator = std::fmod(accumulator, fixed_delta_time);
+		return steps;
+	}
+
+	// Interpolation factor:
+	//     How far the world is between the last
+	//     fixed step and the next one, from 0 to 1.
+	//     Use it in Script::loop and Script::drew to
+	//     blend the last two fixed states.
+	float alpha(void) const { return accumulator / fixed_delta_time; }
+
+	// Fixed delta time of World::tick()
+	float step_time(void) const { return fixed_delta_time; }
+
+	// Sync point:
+	//     Removes killed objects, puts scripts
+	//     granted during dispatches into the
+	//     dispatch lists, sorts and compacts them,
+	//     and destroys what was taken. Runs by itself
+	//     around every outermost World::dispatch(),
+	//     does nothing while dispatching.
+	void sync(void) {
+		if(dispatching) return;
+		flush_kills();
+		settle();
+		return;
+	}
+
+private:
+	// Call a method on every script of a dispatch list
+	template<auto METHOD, typename... ARGS>
+	void sweep(detail::Roster& iroster, ARGS&&... iargs) {
+#ifdef TUNA_PROFILE
+		profiler.frame.visited += iroster.list.size();
+#endif
+		// The list never grows while dispatching
+		for(Script* script : iroster.list) if(script) [[likely]]
+			call<METHOD>(script, std::forward<ARGS>(iargs)...);
+		return;
+	}
+
+	// Call a game loop method on the due bucket of every tier:
+	//     The tier adds up the time, and the due
+	//     bucket gets what was added since it
+	//     last ran, or since a script joined it.
+	template<auto METHOD>
+	void pulse(const float DELTA_TIME) {
+		constexpr std::size_t HOOK = detail::hook_of<METHOD>;
+		for(auto& tier : tiers) {
+			const double total = tier.totals[HOOK] += DELTA_TIME;
+			detail::Bucket& bucket = tier.buckets[tier.turns[HOOK]++ % tier.interval];
+			const double mark = std::exchange(bucket.marks[HOOK], total);
+#ifdef TUNA_PROFILE
+			profiler.frame.visited += bucket.rosters[HOOK].list.size();
+#endif
+			for(Script* script : bucket.rosters[HOOK].list) if(script) [[likely]]
+				call<METHOD>(script, float(total - std::max(mark, script->joined[HOOK])));
+		}
+		return;
+	}
+
+	// Call a method on every script of two dispatch lists, in dispatch order
+	template<auto METHOD, typename... ARGS>
+	void merge(detail::Roster& ifirst, detail::Roster& isecond, ARGS&&... iargs) {
+		Script* const* first = ifirst.list.data();
+		Script* const* second = isecond.list.data();
+		Script* const* const first_end = first + ifirst.list.size();
+		Script* const* const second_end = second + isecond.list.size();
+
+		while(true) {
+			while(first != first_end && !*first) ++first;
+			while(second != second_end && !*second) ++second;
+
+			Script* script;
+			if(first != first_end && (second == second_end || rank_of(*first) < rank_of(*second)))
+				script = *first++;
+			else if(second != second_end) script = *second++;
+			else break;
+
+			call<METHOD>(script, std::forward<ARGS>(iargs)...);
+		}
+#ifdef TUNA_PROFILE
+		profiler.frame.visited += ifirst.list.size() + isecond.list.size();
+#endif
+		return;
+	}
+
+	// Call a method on a script
+	template<auto METHOD, typename T = Script, typename... ARGS>
+	void call(Script* iscript, ARGS&&... iargs) {
+#ifdef TUNA_PROFILE
+		const std::size_t type = iscript->type;
+		const std::uint64_t begin = Profile::now();
+		invoke<METHOD, T>(iscript, std::forward<ARGS>(iargs)...);
+		profiler.sample(type, detail::own_hook_of<T, METHOD>, Profile::now() - begin);
+		++profiler.frame.dispatched;
+#else
+		invoke<METHOD, T>(iscript, std::forward<ARGS>(iargs)...);
+#endif
+		return;
+	}
+
+	// Call a method on every script of exactly type T
+	// from a wave of phases running in parallel
+	template<typename T, auto METHOD>
+	void walk(const float DELTA_TIME) {
+		const std::size_t type = detail::type_of<T>();
+		if(type >= kinds.size()) return;
+		for(Script* script : kinds[type].list) if(script) [[likely]]
+			invoke<METHOD, T>(script, DELTA_TIME);
+		return;
+	}
+
+	// Call a method on a script of exactly type T:
+	//     Game loop methods are called by name,
+	//     so the call is not virtual.
+	template<auto METHOD, typename T, typename... ARGS>
+	static void invoke(Script* iscript, ARGS&&... iargs) {
+		constexpr std::size_t HOOK = detail::own_hook_of<T, METHOD>;
+		if constexpr(std::is_same_v<T, Script>) (iscript->*METHOD)(std::forward<ARGS>(iargs)...);
+		else if constexpr(HOOK == 0) static_cast<T*>(iscript)->T::loop(std::forward<ARGS>(iargs)...);
+		else if constexpr(HOOK == 1) static_cast<T*>(iscript)->T::step(std::forward<ARGS>(iargs)...);
+		else if constexpr(HOOK == 2) static_cast<T*>(iscript)->T::post(std::forward<ARGS>(iargs)...);
+		else if constexpr(HOOK == 3) static_cast<T*>(iscript)->T::drew(std::forward<ARGS>(iargs)...);
+		else (static_cast<T*>(iscript)->*METHOD)(std::forward<ARGS>(iargs)...);
+		return;
+	}
+
+	// Dispatch list manipulations
+
+	// Dispatch order key of a script
+	static detail::Rank rank_of(const Script* iscript) {
+		return detail::Rank{ iscript->rank, iscript->serial };
+	}
+
+	// Dispatch list of a script for a method
+	//     Marks the bucket of a paced script for
+	//     the next sync point.
+	detail::Roster& roster_of(Script* iscript, std::size_t ihook) {
+		if(iscript->tier && ihook < detail::every_hook) {
+			detail::Bucket& bucket = tiers[iscript->tier - 1].buckets[iscript->bucket];
+			if(!bucket.dirty) {
+				bucket.dirty = true;
+				dirty.emplace_back(iscript->tier - 1, iscript->bucket);
+			}
+			return bucket.rosters[ihook];
+		}
+		return iscript->concurrent ? concurrents[ihook] : rosters[ihook];
+	}
+
+	// Set up a task and run it to its first co_await
+	void launch(std::coroutine_handle<Task::promise_type> ihandle, ObjectID iowner, std::size_t itype, std::uint64_t iserial) {
+		Task::promise_type& promise = ihandle.promise();
+		promise.home = this;
+		promise.owner = iowner;
+		promise.type = itype;
+		promise.serial = iserial;
+		++suspended;
+		ihandle.resume();
+		if(ihandle.done()) {
+			--suspended;
+			ihandle.destroy();
+		}
+		return;
+	}
+
+	// Object, and script if any, of a task are still there
+	bool owns(const Task::promise_type& ipromise) {
+		Object* object = alive(ipromise.owner);
+		if(!object) return false;
+		if(ipromise.type == std::size_t(-1)) return true;
+		const std::size_t position = object->locate(ipromise.type);
+		return position != std::size_t(-1) && object->scripts[position]
+			&& object->scripts[position]->serial == ipromise.serial;
+	}
+
+	// Put a task in the slot of the step it waits for
+	void suspend(std::coroutine_handle<Task::promise_type> ihandle, const float SECONDS) {
+		const float steps = std::ceil(SECONDS / fixed_delta_time - 1e-4f);
+		const std::uint64_t wait = steps >= 1.0f ? std::uint64_t(std::min(steps, 1e15f)) : 1;
+		ihandle.promise().due = stepped + wait;
+		wheel[ihandle.promise().due % std::size(wheel)].emplace_back(ihandle);
+		return;
+	}
+
+	// Resume the tasks due on this fixed step:
+	//     Tasks of gone objects are destroyed.
+	//     Nested steps leave the tasks alone.
+	void awaken(void) {
+		++stepped;
+		auto& slot = wheel[stepped % std::size(wheel)];
+		if(awakening || slot.empty()) return;
+		awakening = true;
+		std::swap(due, slot);
+		for(auto handle : due) {
+			if(handle.promise().due > stepped) {
+				wheel[stepped % std::size(wheel)].emplace_back(handle);
+				continue;
+			}
+			if(owns(handle.promise())) {
+				handle.resume();
+				if(!handle.done()) continue;
+			}
+			--suspended;
+			handle.destroy();
+		}
+		due.clear();
+		awakening = false;
+		return;
+	}
+
+	// Destroy every suspended task:
+	//     Tasks being resumed right now are
+	//     left to World::awaken(), which finds
+	//     their objects gone.
+	void drop_tasks(void) {
+		for(auto& slot : wheel) {
+			for(auto handle : slot) handle.destroy();
+			suspended -= slot.size();
+			slot.clear();
+		}
+		return;
+	}
+
+	// Object with copies of a prefab's prototypes,
+	// not yet in the container
+	template<typename... SCRIPTS>
+	std::shared_ptr<Object> instance(const Prefab<SCRIPTS...>& iprefab) {
+		std::shared_ptr<Object> object = std::allocate_shared<Object>(
+			std::pmr::polymorphic_allocator<Object>(arena.get()), objects.vacant(), this);
+		object->reserve(std::max(sizeof...(SCRIPTS), script_capacity));
+		(object->install(std::allocate_shared<SCRIPTS>(std::pmr::polymorphic_allocator<SCRIPTS>(arena.get()),
+			std::get<SCRIPTS>(iprefab.prototypes)), object), ...);
+		return object;
+	}
+
+	// Make room in the dispatch lists for more
+	// scripts of a type, granted outside of tiers
+	template<typename T>
+	void make_room(std::size_t icount) {
+		const std::size_t type = detail::type_of<T>();
+		constexpr unsigned hooks = detail::hooks_of<T>();
+		detail::Roster* lists = detail::is_concurrent<T> ? concurrents : rosters;
+		for(std::size_t hook = 0; hook < std::size(rosters); ++hook) if(hooks & (1u << hook))
+			detail::grow(lists[hook].list, icount);
+		if(type >= kinds.size()) kinds.resize(type + 1);
+		detail::grow(kinds[type].list, icount);
+		return;
+	}
+
+	// Put a granted script into the dispatch lists,
+	// or into the command buffer while dispatching
+	void enroll(Script* iscript, unsigned ihooks) {
+		if(dispatching) pending.emplace_back(iscript, ihooks);
+		else enlist(iscript, ihooks);
+		return;
+	}
+
+	// Append a script to the dispatch lists in the mask
+	void enlist(Script* iscript, unsigned ihooks) {
+		for(std::size_t hook = 0; hook < std::size(rosters); ++hook) if(ihooks & (1u << hook))
+			append(roster_of(iscript, hook), iscript, hook);
+		if(iscript->type >= kinds.size()) kinds.resize(iscript->type + 1);
+		append(kinds[iscript->type], iscript, detail::own_type);
+		return;
+	}
+
+	// Append a script to one dispatch list
+	static void append(detail::Roster& iroster, Script* iscript, std::size_t islot) {
+		const detail::Rank rank = rank_of(iscript);
+		if(refill(iroster, iscript, islot, rank)) return;
+		if(rank >= iroster.tail) iroster.tail = rank;
+		else if(!iroster.unsorted) {
+			iroster.unsorted = true;
+			iroster.ordered = iroster.list.size();
+		}
+		iscript->slots[islot] = iroster.list.size();
+		iroster.list.emplace_back(iscript);
+		return;
+	}
+
+	// Put a script back into the hole it left:
+	//     Taking a hole between a script ranked
+	//     lower and one ranked higher keeps a
+	//     sorted list sorted, so waking a script
+	//     takes constant time. Holes of any script
+	//     qualify, the position is only a hint.
+	static bool refill(detail::Roster& iroster, Script* iscript, std::size_t islot, const detail::Rank& irank) {
+		constexpr std::size_t reach = 4;
+		const std::size_t slot = iscript->slots[islot];
+		if(iroster.unsorted || slot >= iroster.list.size() || iroster.list[slot]) return false;
+
+		for(std::size_t step = 1; step <= slot; ++step) {
+			if(step > reach) return false;
+			if(const Script* before = iroster.list[slot - step]) {
+				if(!(rank_of(before) < irank)) return false;
+				break;
+			}
+		}
+		for(std::size_t step = 1; slot + step < iroster.list.size(); ++step) {
+			if(step > reach) return false;
+			if(const Script* after = iroster.list[slot + step]) {
+				if(!(irank < rank_of(after))) return false;
+				break;
+			}
+		}
+		iroster.list[slot] = iscript;
+		--iroster.holes;
+		return true;
+	}
+
+	// Leave a hole in place of a script in every dispatch list
+	void delist(Script* iscript) {
+		unlist(iscript);
+		if(dispatching && !paces.empty())
+			std::erase_if(paces, [iscript](const std::pair<Script*, std::size_t>& ientry) {
+				return ientry.first == iscript;
+			});
+		if(iscript->tier) {
+			--tiers[iscript->tier - 1].buckets[iscript->bucket].members;
+			iscript->tier = 0;
+		}
+		return;
+	}
+
+	// Move an enlisted script to the tier of an interval:
+	//     It joins the given bucket or else the
+	//     emptiest one, so each bucket costs
+	//     about the same.
+	void retier(Script* iscript, std::size_t iinterval, std::size_t ibucket = -1) {
+		iinterval = std::max<std::size_t>(std::min(iinterval, detail::Tier::max_interval), 1);
+		const std::size_t current = iscript->tier ? tiers[iscript->tier - 1].interval : 1;
+		if(iinterval == current && (ibucket >= iinterval || ibucket == iscript->bucket)) return;
+
+		// Sleeping scripts are out of the lists already
+		const unsigned hooks = iscript->asleep ? 0u : iscript->hooks & ((1u << detail::every_hook) - 1);
+		for(std::size_t hook = 0; hook < detail::every_hook; ++hook) if(hooks & (1u << hook))
+			remove(roster_of(iscript, hook), iscript, hook);
+		if(iscript->tier) --tiers[iscript->tier - 1].buckets[iscript->bucket].members;
+		iscript->tier = 0;
+
+		if(iinterval > 1) {
+			detail::Tier& tier = tier_of(iinterval);
+			auto bucket = ibucket < iinterval ? tier.buckets.begin() + ibucket
+				: std::min_element(tier.buckets.begin(), tier.buckets.end(),
+					[](const detail::Bucket& ileft, const detail::Bucket& iright) {
+						return ileft.members < iright.members;
+					}
+				);
+			++bucket->members;
+			std::copy(std::begin(tier.totals), std::end(tier.totals), std::begin(iscript->joined));
+			iscript->tier = std::uint32_t(&tier - tiers.data() + 1);
+			iscript->bucket = std::uint32_t(bucket - tier.buckets.begin());
+		}
+
+		for(std::size_t hook = 0; hook < detail::every_hook; ++hook) if(hooks & (1u << hook))
+			append(roster_of(iscript, hook), iscript, hook);
+		return;
+	}
+
+	// Tier of an interval, created if missing
+	detail::Tier& tier_of(std::size_t iinterval) {
+		for(auto& tier : tiers) if(tier.interval == iinterval) return tier;
+		return tiers.emplace_back(detail::Tier{ iinterval, {}, std::vector<detail::Bucket>(iinterval), {} });
+	}
+
+	// Change the tier of a script, or queue it while dispatching
+	void pace(Script* iscript, std::size_t iinterval) {
+		if(dispatching) paces.emplace_back(iscript, iinterval);
+		else retier(iscript, iinterval);
+		return;
+	}
+
+	// Take a script out of every dispatch list and
+	// the command buffer, keeping its tier
+	void unlist(Script* iscript) {
+		if(dispatching && !pending.empty())
+			std::erase_if(pending, [iscript](const std::pair<Script*, unsigned>& ientry) {
+				return ientry.first == iscript;
+			});
+		for(std::size_t hook = 0; hook < std::size(rosters); ++hook)
+			remove(roster_of(iscript, hook), iscript, hook);
+		if(iscript->type < kinds.size()) remove(kinds[iscript->type], iscript, detail::own_type);
+		return;
+	}
+
+	// Leave a hole in place of a script in one dispatch list
+	static void remove(detail::Roster& iroster, Script* iscript, std::size_t islot) {
+		std::size_t& slot = iscript->slots[islot];
+		if(slot >= iroster.list.size() || iroster.list[slot] != iscript) return;
+		// The position is kept for World::refill()
+		iroster.list[slot] = nullptr;
+		++iroster.holes;
+		return;
+	}
+
+	// Keep a script alive until the dispatch is over
+	void bury(std::shared_ptr<Script>&& iscript) {
+		if(dispatching) graveyard.emplace_back(std::move(iscript));
+		return;
+	}
+
+	// Blob header
+	static constexpr std::uint32_t blob_magic = 0x616e7574;
+	static constexpr std::uint32_t blob_version = 4;
+
+	// What World::read() does with a blob:
+	//     Load it into the clean world, check
+	//     that the world has the same objects,
+	//     scripts and components, or read it
+	//     into them in place.
+	enum class Pass { load, check, reread };
+
+	// Read a blob
+	bool read(std::span<const std::byte> iblob, Pass ipass) {
+		Reader reader(iblob);
+		if(reader.read<std::uint32_t>() != blob_magic || reader.read<std::uint32_t>() != blob_version) return false;
+
+		// Types of the blob by their position in it
+		const auto& table = detail::serializers();
+		const std::uint32_t named = reader.read<std::uint32_t>();
+		if(named > reader.remaining() / sizeof(std::uint32_t)) return false;
+		std::vector<std::size_t> local(named, std::size_t(-1));
+		for(std::size_t& type : local) {
+			const std::string name = reader.text();
+			for(std::size_t known = 0; known < table.size(); ++known)
+				if(table[known].name == name) type = known;
+		}
+		auto entry_of = [&](std::uint32_t itype) -> const detail::Serializer* {
+			return itype < local.size() && local[itype] < table.size() ? &table[local[itype]] : nullptr;
+		};
+
+		const float fixed = reader.read<float>();
+		const std::uint64_t steps = reader.read<std::uint64_t>();
+		const float accumulated = reader.read<float>();
+		const std::uint64_t granted = reader.read<std::uint64_t>();
+		if(ipass != Pass::check) {
+			fixed_delta_time = fixed;
+			max_steps = std::max<std::size_t>(steps, 1);
+			accumulator = accumulated;
+		}
+
+		const std::uint64_t slots = reader.read<std::uint64_t>();
+		if(reader.failed() || slots > reader.remaining() / sizeof(std::uint32_t)) return false;
+		std::vector<std::uint32_t> generations(slots);
+		reader.read(generations.data(), generations.size() * sizeof(std::uint32_t));
+		const std::uint64_t vacant = reader.read<std::uint64_t>();
+		if(reader.failed() || vacant > reader.remaining() / sizeof(std::uint32_t)) return false;
+		std::vector<std::uint32_t> vacancies(vacant);
+		reader.read(vacancies.data(), vacancies.size() * sizeof(std::uint32_t));
+
+		// Tiers of the blob replace the turns of every tier
+		if(ipass != Pass::check) for(auto& tier : tiers) {
+			std::fill(std::begin(tier.turns), std::end(tier.turns), 0);
+			for(auto& bucket : tier.buckets) std::copy(std::begin(tier.totals), std::end(tier.totals), std::begin(bucket.marks));
+		}
+		const std::uint32_t tiered = reader.read<std::uint32_t>();
+		for(std::uint32_t next = 0; next < tiered && !reader.failed(); ++next) {
+			const std::uint64_t interval = reader.read<std::uint64_t>();
+			if(interval < 2 || interval > detail::Tier::max_interval) return false;
+			std::uint64_t turns[4];
+			reader.read(turns, sizeof(turns));
+			float elapsed[4];
+			if(interval > reader.remaining() / sizeof(elapsed)) return false;
+			if(ipass == Pass::check) {
+				reader.skip(interval * sizeof(elapsed));
+				continue;
+			}
+			// Saved time is what the bucket is owed
+			detail::Tier& tier = tier_of(interval);
+			for(std::size_t hook = 0; hook < std::size(turns); ++hook) tier.turns[hook] = turns[hook];
+			for(auto& bucket : tier.buckets) {
+				reader.read(elapsed, sizeof(elapsed));
+				for(std::size_t hook = 0; hook < std::size(elapsed); ++hook) bucket.marks[hook] = tier.totals[hook] - elapsed[hook];
+			}
+		}
+
+		const std::uint64_t count = reader.read<std::uint64_t>();
+		if(reader.failed() || count > reader.remaining() / (2 * sizeof(ObjectID) + 2 * sizeof(std::uint32_t))) return false;
+		if(ipass != Pass::load && count != objects.size()) return false;
+		std::vector<Objects::value_type> loaded;
+		if(ipass == Pass::load) {
+			loaded.reserve(count);
+			objects.reserve(count);
+		}
+		std::vector<ObjectID> owned;
+
+		for(std::uint64_t next = 0; next < count; ++next) {
+			const ObjectID id = reader.read<ObjectID>();
+			const ObjectID owner = reader.read<ObjectID>();
+			const std::uint32_t owned_count = reader.read<std::uint32_t>();
+			if(owned_count > reader.remaining() / sizeof(ObjectID)) return false;
+			owned.resize(owned_count);
+			reader.read(owned.data(), owned.size() * sizeof(ObjectID));
+
+			std::shared_ptr<Object> made;
+			Object* object = nullptr;
+			if(ipass == Pass::load) {
+				made = std::allocate_shared<Object>(std::pmr::polymorphic_allocator<Object>(arena.get()), id, this);
+				object = made.get();
+			}
+			else {
+				auto current = objects.begin() + next;
+				if(current->first != id || !current->second) return false;
+				object = current->second.get();
+			}
+			if(ipass != Pass::check) {
+				object->owner_id = owner;
+				object->owned_ids = owned;
+			}
+
+			const std::uint32_t scripts = reader.read<std::uint32_t>();
+			if(scripts > reader.remaining() / (3 * sizeof(std::uint32_t) + 2 * sizeof(std::uint64_t) + 4 * sizeof(float))) return false;
+			if(ipass == Pass::load) {
+				object->scripts.reserve(scripts);
+				object->index.reserve(scripts);
+			}
+
+			// Saved scripts already on the object, in order
+			std::size_t position = 0;
+			auto saved = [&](void) -> Script* {
+				while(position < object->scripts.size()) {
+					Script* script = object->scripts[position++].get();
+					if(script && script->type < table.size() && table[script->type].save) return script;
+				}
+				return nullptr;
+			};
+
+			for(std::uint32_t script = 0; script < scripts; ++script) {
+				const std::uint32_t type = reader.read<std::uint32_t>();
+				const bool asleep = reader.read<std::uint8_t>();
+				const std::uint32_t interval = reader.read<std::uint32_t>();
+				const std::uint32_t bucket = reader.read<std::uint32_t>();
+				const std::uint64_t serial = reader.read<std::uint64_t>();
+				float since[4];
+				reader.read(since, sizeof(since));
+				const std::uint64_t size = reader.read<std::uint64_t>();
+				if(reader.failed() || size > reader.remaining() || interval > detail::Tier::max_interval || serial >= granted) return false;
+
+				const detail::Serializer* entry = entry_of(type);
+				if(entry && entry->load) {
+					Reader payload(iblob.subspan(reader.position(), size));
+					Script* target = nullptr;
+					if(ipass == Pass::load) {
+						// Granted with the saved serial
+						serials = serial;
+						target = entry->load(*object, payload);
+						if(!target) return false;
+					}
+					else {
+						target = saved();
+						if(!target || &table[target->type] != entry) return false;
+						if(ipass == Pass::reread && !entry->read(*target, payload)) return false;
+					}
+					if(ipass == Pass::reread && target->serial != serial) {
+						// Put back in the saved dispatch order
+						target->sleep();
+						target->serial = serial;
+					}
+					if(ipass != Pass::check) {
+						retier(target, interval, bucket);
+						if(target->tier) for(std::size_t hook = 0; hook < std::size(since); ++hook)
+							target->joined[hook] = tiers[target->tier - 1].totals[hook] - since[hook];
+						if(asleep) target->sleep();
+						else target->wake();
+					}
+				}
+				reader.skip(size);
+			}
+			if(ipass != Pass::load && saved()) return false;
+			if(ipass == Pass::load) loaded.emplace_back(id, std::move(made));
+		}
+		if(reader.failed()) return false;
+		if(ipass != Pass::check) serials = granted;
+		if(ipass == Pass::load && !objects.restore(std::move(loaded), generations, vacancies)) return false;
+		if(ipass == Pass::reread && !objects.restore(objects.extract(), generations, vacancies)) return false;
+
+		// Component pools the blob has no record of must be empty
+		std::vector<bool> seen(pools.size(), false);
+		const std::uint32_t components = reader.read<std::uint32_t>();
+		for(std::uint32_t next = 0; next < components && !reader.failed(); ++next) {
+			const std::uint32_t type = reader.read<std::uint32_t>();
+			const std::uint64_t amount = reader.read<std::uint64_t>();
+			const std::uint64_t size = reader.read<std::uint64_t>();
+			if(reader.failed() || size > reader.remaining()) return false;
+
+			const detail::Serializer* entry = entry_of(type);
+			if(!entry || !entry->pool) {
+				reader.skip(size);
+				continue;
+			}
+			const std::size_t known = local[type];
+			Reader payload(iblob.subspan(reader.position(), size));
+			const std::byte* owners = iblob.data() + reader.position();
+			reader.skip(size);
+
+			if(ipass == Pass::check) {
+				// Same owners, so attached types stay right
+				if(known >= pools.size() || !pools[known]) {
+					if(amount) return false;
+					continue;
+				}
+				const auto& current = pools[known]->owners;
+				if(current.size() != amount || amount > size / sizeof(ObjectID)) return false;
+				if(amount && std::memcmp(current.data(), owners, amount * sizeof(ObjectID))) return false;
+				seen[known] = true;
+				continue;
+			}
+
+			if(known >= pools.size()) pools.resize(known + 1);
+			if(!pools[known]) pools[known] = entry->pool();
+			if(!pools[known]->load(payload, amount, generations.size())) return false;
+			if(ipass == Pass::load) for(ObjectID owner : pools[known]->owners) {
+				Object* object = alive(owner);
+				if(!object) return false;
+				object->attached.emplace_back(known);
+			}
+		}
+		if(ipass == Pass::check)
+			for(std::size_t type = 0; type < pools.size(); ++type)
+				if(pools[type] && !seen[type] && type < table.size() && table[type].pool && !pools[type]->owners.empty()) return false;
+
+		// Spatial index, of objects the blob has
+		if(!spare.load(reader, generations.size())) return false;
+		for(const auto& entry : spare.entries) if(!objects.contains(entry.id)) return false;
+		if(ipass != Pass::check) std::swap(grid, spare);
+		return !reader.failed();
+	}
+
+	// Component pool of a type, created if missing
+	template<typename T>
+	detail::Components<T>& pool_of(void) {
+		const std::size_t type = detail::type_of<T>();
+		if(type >= pools.size()) pools.resize(type + 1);
+		if(!pools[type]) pools[type] = std::make_unique<detail::Components<T>>();
+		return static_cast<detail::Components<T>&>(*pools[type]);
+	}
+
+	// Component pool of a type or nullptr
+	template<typename T>
+	detail::Components<T>* pool_if(void) {
+		const std::size_t type = detail::type_of<T>();
+		if(type >= pools.size()) return nullptr;
+		return static_cast<detail::Components<T>*>(pools[type].get());
+	}
+
+	// Live object that is not doomed, or nullptr
+	Object* alive(ObjectID iid) {
+		auto found = objects.find(iid);
+		if(found == objects.end() || !found->second || found->second->doomed) return nullptr;
+		return found->second.get();
+	}
+
+	// Queue an object and everything it owns for removal once
+	void doom(Object& iobject) {
+		if(iobject.doomed) return;
+		iobject.doomed = true;
+		kill_queue.emplace_back(iobject.id);
+
+		for(std::size_t next = kill_queue.size() - 1; next < kill_queue.size(); ++next) {
+			auto found = objects.find(kill_queue[next]);
+			for(ObjectID id : found->second->owned_ids) {
+				auto owned = objects.find(id);
+				if(owned == objects.end() || !owned->second || owned->second->doomed) continue;
+				owned->second->doomed = true;
+				kill_queue.emplace_back(id);
+			}
+		}
+		return;
+	}
+
+	// Empty everything for World::clean():
+	//     Returns the extracted objects. Lists
+	//     being walked keep their storage and
+	//     are only hollowed out.
+	std::vector<Objects::value_type> strip(void) {
+		std::vector<Objects::value_type> ruins = objects.extract();
+		kill_queue.clear();
+		pending.clear();
+		paces.clear();
+		for(auto& pool : pools) if(pool) pool->clear();
+		for(auto& channel : channels) if(channel) channel->clear();
+		grid.clear();
+		drop_tasks();
+
+		if(dispatching) {
+			for(auto& roster : rosters) hollow(roster);
+			for(auto& roster : concurrents) hollow(roster);
+			for(auto& roster : kinds) hollow(roster);
+			for(std::size_t tier = 0; tier < tiers.size(); ++tier)
+				for(std::size_t index = 0; index < tiers[tier].buckets.size(); ++index) {
+					detail::Bucket& bucket = tiers[tier].buckets[index];
+					for(auto& roster : bucket.rosters) hollow(roster);
+					bucket.members = 0;
+					if(!bucket.dirty) {
+						bucket.dirty = true;
+						dirty.emplace_back(std::uint32_t(tier), std::uint32_t(index));
+					}
+				}
+			return ruins;
+		}
+
+		for(auto& roster : rosters) roster = detail::Roster();
+		for(auto& roster : concurrents) roster = detail::Roster();
+		for(auto& roster : kinds) roster = detail::Roster();
+		for(auto& tier : tiers) {
+			for(auto& bucket : tier.buckets) bucket = detail::Bucket();
+			std::fill(std::begin(tier.turns), std::end(tier.turns), 0);
+			std::fill(std::begin(tier.totals), std::end(tier.totals), 0.0);
+		}
+		dirty.clear();
+		return ruins;
+	}
+
+	// Destroy extracted objects and release their arena
+	static void raze(std::vector<Objects::value_type>& iruins, detail::Arena& iarena) {
+		iarena.scrap(true);
+		for(auto& [objectid, object] : iruins) if(object) {
+			object->home = nullptr;
+			// Objects held elsewhere keep their scripts
+			if(object.use_count() == 1)
+				while(!object->scripts.empty()) {
+					if(object->scripts.back()) object->scripts.back()->holder = nullptr;
+					object->scripts.pop_back();
+				}
+		}
+		iruins.clear();
+		iarena.scrap(false);
+		iarena.release();
+		return;
+	}
+
+	// Leave holes in place of every script of a dispatch list
+	static void hollow(detail::Roster& iroster) {
+		std::fill(iroster.list.begin(), iroster.list.end(), nullptr);
+		iroster.holes = iroster.list.size();
+		return;
+	}
+
+	// Compact a dispatch list once it gets too holey,
+	// or once it has any holes with iany
+	static void compact(detail::Roster& iroster, std::size_t ihook, bool iany = false) {
+		if(!iroster.holes || (!iany && iroster.holes * 4 <= iroster.list.size())) return;
+		std::size_t next = 0;
+		for(Script* script : iroster.list) if(script) {
+			script->slots[ihook] = next;
+			iroster.list[next++] = script;
+		}
+		iroster.list.resize(next);
+		iroster.holes = 0;
+		return;
+	}
+
+	// Compact a dispatch list with any holes
+	// and release its spare capacity
+	static void squeeze(detail::Roster& iroster, std::size_t ihook) {
+		compact(iroster, ihook, true);
+		iroster.list.shrink_to_fit();
+		return;
+	}
+
+	// Sort a dispatch list broken by an append:
+	//     Only the scripts appended since the
+	//     break are sorted, then merged into the
+	//     sorted head, so waking or granting a few
+	//     scripts costs one pass over the list.
+	static void sort(detail::Roster& iroster, std::size_t ihook) {
+		if(!iroster.unsorted) return;
+		auto by_rank = [](const Script* ileft, const Script* iright) {
+			return rank_of(ileft) < rank_of(iright);
+		};
+
+		// Drop the holes, noting where the head ends
+		// and where the first script moved
+		std::size_t next = 0, head = 0, moved = iroster.list.size();
+		for(std::size_t slot = 0; slot < iroster.list.size(); ++slot) {
+			if(slot == iroster.ordered) head = next;
+			if(Script* script = iroster.list[slot]) iroster.list[next++] = script;
+			else moved = std::min(moved, next);
+		}
+		iroster.list.resize(next);
+
+		const auto middle = iroster.list.begin() + head;
+		std::sort(middle, iroster.list.end(), by_rank);
+		if(middle != iroster.list.end())
+			moved = std::min<std::size_t>(moved, std::upper_bound(iroster.list.begin(), middle, *middle, by_rank) - iroster.list.begin());
+		// A short tail is rotated into place without a buffer
+		if(iroster.list.end() - middle <= 8)
+			for(auto next_script = middle; next_script != iroster.list.end(); ++next_script)
+				std::rotate(std::upper_bound(iroster.list.begin(), next_script, *next_script, by_rank), next_script, next_script + 1);
+		else std::inplace_merge(iroster.list.begin(), middle, iroster.list.end(), by_rank);
+		for(std::size_t slot = moved; slot < iroster.list.size(); ++slot)
+			iroster.list[slot]->slots[ihook] = slot;
+		iroster.holes = 0;
+		iroster.unsorted = false;
+		return;
+	}
+
+	// Apply the command buffer, sort and compact
+	// the dispatch lists and release the graveyard
+	void settle(void) {
+		for(auto& [script, hooks] : pending) enlist(script, hooks);
+		pending.clear();
+		for(auto& [script, interval] : paces) retier(script, interval);
+		paces.clear();
+		for(std::size_t hook = 0; hook < std::size(rosters); ++hook) {
+			sort(rosters[hook], hook);
+			sort(concurrents[hook], hook);
+			compact(rosters[hook], hook);
+			compact(concurrents[hook], hook);
+		}
+		for(auto& roster : kinds) {
+			sort(roster, detail::own_type);
+			compact(roster, detail::own_type);
+		}
+		for(auto [tier, index] : dirty) {
+			detail::Bucket& bucket = tiers[tier].buckets[index];
+			for(std::size_t hook = 0; hook < std::size(bucket.rosters); ++hook) {
+				sort(bucket.rosters[hook], hook);
+				compact(bucket.rosters[hook], hook);
+			}
+			bucket.dirty = false;
+		}
+		dirty.clear();
+		graveyard.clear();
+		return;
+	}
+};
+
+class History {
+private:
+	// Ring of saved frames, reused as it turns
+	std::vector<std::vector<std::byte>> frames;
+	// Slot of the oldest frame and frames kept
+	std::size_t first = 0;
+	std::size_t count = 0;
+
+public:
+	// History keeping up to iframes frames
+	explicit History(std::size_t iframes) : frames(std::max<std::size_t>(iframes, 1)) { return; }
+
+	// Save a frame of the world:
+	//     The oldest frame is dropped once the
+	//     history is full. Frame blobs keep their
+	//     memory, so recording allocates only
+	//     while the world grows.
+	bool record(World& iworld) {
+		std::vector<std::byte>& frame = frames[(first + count) % frames.size()];
+		frame.clear();
+		if(!iworld.save(frame)) return false;
+		if(count < frames.size()) ++count;
+		else first = (first + 1) % frames.size();
+		return true;
+	}
+
+	// Bring the world back iframes frames:
+	//     Zero is the last recorded frame.
+	//     Newer frames are dropped, the one
+	//     restored stays the last. Fails if
+	//     the history is not that long.
+	bool rewind(World& iworld, std::size_t iframes = 0) {
+		if(iframes >= count) return false;
+		count -= iframes;
+		return iworld.restore(frames[(first + count - 1) % frames.size()]);
+	}
+
+	// Frames recorded
+	std::size_t size(void) const { return count; }
+	// Most frames kept
+	std::size_t capacity(void) const { return frames.size(); }
+
+	// Drop every frame, keeping their memory
+	void clear(void) {
+		first = 0;
+		count = 0;
+		return;
+	}
+};
+
+template<typename... SCRIPTS>
+class Prefab {
+	friend class World;
+	static_assert((std::is_base_of_v<Script, SCRIPTS> && ...), "Prefabs are made of scripts");
+	static_assert((std::is_copy_constructible_v<SCRIPTS> && ...), "Prefab scripts must be copyable");
+	static_assert(detail::Distinct<SCRIPTS...>::value, "Prefab script types must be distinct");
+
+private:
+	// Scripts copied onto every spawned object
+	std::tuple<SCRIPTS...> prototypes;
+
+public:
+	// Default constructor
+	Prefab(void) = default;
+	// Prefab of prototype scripts
+	explicit Prefab(SCRIPTS... iprototypes) requires(sizeof...(SCRIPTS) > 0) : prototypes(std::move(iprototypes)...) { return; }
+
+	// Prototype of a script type
+	template<typename T>
+	T& prototype(void) { return std::get<T>(prototypes); }
+	template<typename T>
+	const T& prototype(void) const { return std::get<T>(prototypes); }
+};
+
+namespace detail {
+
+// Types a phase reads and writes
+template<typename> struct Access {
+	static_assert(sizeof(Access*) == 0, "Phase access is tuna::Reads or tuna::Writes");
+};
+template<typename... TS>
+struct Access<Reads<TS...>> {
+	static void add(std::vector<std::size_t>& ireads, std::vector<std::size_t>&) {
+		(ireads.emplace_back(type_of<TS>()), ...);
+		return;
+	}
+};
+template<typename... TS>
+struct Access<Writes<TS...>> {
+	static void add(std::vector<std::size_t>&, std::vector<std::size_t>& iwrites) {
+		(iwrites.emplace_back(type_of<TS>()), ...);
+		return;
+	}
+};
+
+} // namespace detail
+
+class Schedule {
+	friend class World;
+
+private:
+	// Declared dispatch:
+	//     Called on its own, or from a wave
+	//     of phases running in parallel.
+	struct Phase {
+		void (*alone)(World&, const float);
+		void (*shared)(World&, const float);
+		std::vector<std::size_t> reads;
+		std::vector<std::size_t> writes;
+		// Touches every script in the world
+		bool barrier;
+	};
+
+	std::vector<Phase> phases;
+	// Phases by wave:
+	//     A phase goes one wave after the
+	//     last earlier phase it conflicts
+	//     with, so the graph is built as
+	//     phases are declared.
+	std::vector<std::vector<std::size_t>> waves;
+	std::vector<std::size_t> levels;
+
+public:
+	// Default constructor
+	Schedule(void) = default;
+
+	// Declare a phase calling a method on every script:
+	//     Same as World::dispatch(), so it
+	//     conflicts with every other phase and
+	//     runs in a wave of its own.
+	template<auto METHOD>
+	std::size_t phase(void) {
+		return add(Phase{ &dispatch<METHOD>, &dispatch<METHOD>, {}, {}, true });
+	}
+
+	// Declare a phase calling a method on every script of exactly type T:
+	//     Same as World::dispatch<T, METHOD>().
+	//     List the types it reads and writes as
+	//     tuna::Reads and tuna::Writes, the script
+	//     type is written by itself. Phases that
+	//     write what another one reads or writes
+	//     run in declaration order, the rest share
+	//     a wave. Returns the phase index.
+	template<typename T, auto METHOD, typename... ACCESS>
+	std::size_t phase(void) {
+		static_assert(std::is_base_of_v<Script, T>, "Only scripts are dispatched");
+		static_assert(std::is_invocable_v<decltype(METHOD), T&, const float>, "Phases take the delta time");
+		Phase declared{ &dispatch<T, METHOD>, &walk<T, METHOD>, {}, { detail::type_of<T>() }, false };
+		(detail::Access<ACCESS>::add(declared.reads, declared.writes), ...);
+		return add(std::move(declared));
+	}
+
+	// Amount of phases
+	std::size_t size(void) const { return phases.size(); }
+	// Amount of waves
+	std::size_t depth(void) const { return waves.size(); }
+	// Wave a phase runs in
+	std::size_t level(std::size_t iphase) const { return levels[iphase]; }
+
+	// Drop every phase
+	void clear(void) {
+		phases.clear();
+		waves.clear();
+		levels.clear();
+		return;
+	}
+
+private:
+	template<auto METHOD>
+	static void dispatch(World& iworld, const float DELTA_TIME) {
+		iworld.dispatch<METHOD>(DELTA_TIME);
+		return;
+	}
+	template<typename T, auto METHOD>
+	static void dispatch(World& iworld, const float DELTA_TIME) {
+		iworld.dispatch<T, METHOD>(DELTA_TIME);
+		return;
+	}
+	template<typename T, auto METHOD>
+	static void walk(World& iworld, const float DELTA_TIME) {
+		iworld.walk<T, METHOD>(DELTA_TIME);
+		return;
+	}
+
+	// One of the lists has a type of the other
+	static bool overlap(const std::vector<std::size_t>& ifirst, const std::vector<std::size_t>& isecond) {
+		for(std::size_t type : ifirst)
+			if(std::find(isecond.begin(), isecond.end(), type) != isecond.end()) return true;
+		return false;
+	}
+
+	// Phases must not share a wave
+	static bool conflict(const Phase& ifirst, const Phase& isecond) {
+		return ifirst.barrier || isecond.barrier
+			|| overlap(ifirst.writes, isecond.writes)
+			|| overlap(ifirst.writes, isecond.reads)
+			|| overlap(ifirst.reads, isecond.writes);
+	}
+
+	// Put a phase one wave after its last conflict
+	std::size_t add(Phase&& iphase) {
+		std::size_t wave = 0;
+		for(std::size_t index = 0; index < phases.size(); ++index)
+			if(levels[index] >= wave && conflict(phases[index], iphase)) wave = levels[index] + 1;
+
+		const std::size_t index = phases.size();
+		phases.emplace_back(std::move(iphase));
+		levels.emplace_back(wave);
+		if(waves.size() <= wave) waves.resize(wave + 1);
+		waves[wave].emplace_back(index);
+		return index;
+	}
+};
+
+class Universe {
+public:
+	// Cost of the last run:
+	//     Wall time of the whole run and busy
+	//     time of every thread that ran worlds,
+	//     the calling one first, in nanoseconds.
+	struct Stats {
+		std::uint64_t wall = 0;
+		std::uint64_t slowest = 0;
+		std::vector<std::uint64_t> busy;
+
+		// Share of the threads' time spent on
+		// worlds, from 0 to 1. Low values with
+		// a slowest world close to the wall time
+		// mean one match holds the rest back.
+		double utilization(void) const {
+			std::uint64_t total = 0;
+			for(std::uint64_t time : busy) total += time;
+			return wall && !busy.empty() ? double(total) / double(wall * busy.size()) : 0.0;
+		}
+	};
+
+private:
+	// World and what its last run cost
+	struct Entry {
+		std::unique_ptr<World> world;
+		std::uint64_t cost = 0;
+		std::size_t steps = 0;
+	};
+
+	std::vector<Entry> entries;
+	// Worlds by last cost, cheapest first
+	std::vector<std::size_t> order;
+	Stats last;
+
+public:
+	// Default constructor
+	Universe(void) = default;
+
+	Universe(const Universe&) = delete;
+	Universe& operator=(const Universe&) = delete;
+
+	// Create a world in the universe:
+	//     Every world has its own arena on top
+	//     of the provided memory resource, so
+	//     worlds never share an allocator lock
+	//     unless the resource has one.
+	World& create(std::pmr::memory_resource* iupstream = std::pmr::get_default_resource()) {
+		entries.emplace_back(Entry{ std::make_unique<World>(iupstream) });
+		return *entries.back().world;
+	}
+
+	// Destroy a world of the universe
+	bool destroy(World& iworld) {
+		auto found = std::find_if(entries.begin(), entries.end(), [&iworld](const Entry& ientry) {
+			return ientry.world.get() == &iworld;
+		});
+		if(found == entries.end()) return false;
+		entries.erase(found);
+		return true;
+	}
+
+	// Amount of worlds
+	std::size_t size(void) const { return entries.size(); }
+	// World by creation order
+	World& at(std::size_t iindex) { return *entries[iindex].world; }
+
+	// Nanoseconds the last run spent on a world
+	std::uint64_t cost(std::size_t iindex) const { return entries[iindex].cost; }
+	// Fixed steps World::tick() ran on a world last time
+	std::size_t steps(std::size_t iindex) const { return entries[iindex].steps; }
+	// Cost of the last run
+	const Stats& stats(void) const { return last; }
+
+	// Call a method on every world's scripts, worlds in parallel:
+	//     Same as World::dispatch() on each
+	//     world, with worlds spread across the
+	//     shared job system one by one. Scripts
+	//     must only touch their own world.
+	template<auto METHOD, typename... ARGS>
+	void dispatch(ARGS&&... iargs) {
+		run([&](World& iworld) {
+			iworld.dispatch<METHOD>(iargs...);
+			return std::size_t(0);
+		});
+		return;
+	}
+
+	// Run fixed steps on every world, worlds in parallel:
+	//     Same as World::tick() on each world.
+	//     Returns the amount of steps of all of them.
+	std::size_t tick(const float REAL_DELTA_TIME) {
+		run([REAL_DELTA_TIME](World& iworld) { return iworld.tick(REAL_DELTA_TIME); });
+		std::size_t total = 0;
+		for(const Entry& entry : entries) total += entry.steps;
+		return total;
+	}
+
+private:
+	static std::uint64_t now(void) {
+		return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	// Run ifn on every world and time it:
+	//     The costliest worlds of the last run
+	//     are queued last, which is where each
+	//     worker takes its own work from first.
+	template<typename FN>
+	void run(const FN& ifn) {
+		const std::uint64_t begin = now();
+		if(order.size() != entries.size()) {
+			order.resize(entries.size());
+			for(std::size_t index = 0; index < order.size(); ++index) order[index] = index;
+		}
+		std::sort(order.begin(), order.end(), [this](std::size_t ileft, std::size_t iright) {
+			return entries[ileft].cost < entries[iright].cost;
+		});
+
+		auto body = [&](std::size_t ibegin, std::size_t iend) {
+			for(std::size_t next = ibegin; next < iend; ++next) {
+				Entry& entry = entries[order[next]];
+				const std::uint64_t start = now();
+				entry.steps = ifn(*entry.world);
+				entry.cost = now() - start;
+				last.busy[Jobs::worker()] += entry.cost;
+			}
+			return;
+		};
+		last.busy.assign(Jobs::shared().size() + 1, 0);
+		Jobs::shared().run(entries.size(), body, 1);
+
+		last.wall = now() - begin;
+		last.slowest = 0;
+		for(const Entry& entry : entries) last.slowest = std::max(last.slowest, entry.cost);
+		return;
+	}
+};
+
+	// Deferred implementation
+
+inline void Objects::emplace(std::shared_ptr<Object>&& iobject) {
+	const ObjectID id = iobject->id;
+	const std::uint32_t index = index_of(id);
+	if(index == slots.size()) slots.emplace_back(Slot{ vacant_slot, generation_of(id) });
+	else vacants.pop_back();
+	slots[index].dense = std::uint32_t(dense.size());
+	dense.emplace_back(id, std::move(iobject));
+	return;
+}
+
+template<typename T, typename... ARGS>
+std::weak_ptr<T> Object::grant(ARGS&&... iargs) {
+	const std::size_t type = detail::type_of<T>();
+
+	// If a script is already on the object -- return it
+	if(const std::size_t position = locate(type); position != std::size_t(-1))
+		return std::static_pointer_cast<T>(scripts[position]);
+
+	std::shared_ptr<T> script = home
+		? std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(home->arena.get()), std::forward<ARGS>(iargs)...)
+		: std::make_shared<T>(std::forward<ARGS>(iargs)...);
+	std::weak_ptr<T> ref(script);
+	install(std::move(script), shared_from_this());
+	return ref;
+}
+
+template<typename T>
+void Object::install(std::shared_ptr<T>&& iscript, const std::shared_ptr<Object>& iparent) {
+	const std::size_t type = detail::type_of<T>();
+	Script* script = iscript.get();
+	script->parent = iparent;
+	script->holder = this;
+	script->type = type;
+	script->concurrent = detail::is_concurrent<T>;
+	script->rank = T::order;
+	script->hooks = detail::hooks_of<T>();
+	script->tier = 0;
+	script->bucket = 0;
+	script->asleep = false;
+	std::fill(std::begin(script->slots), std::end(script->slots), std::size_t(-1));
+	if(home) script->serial = home->serials++;
+	index.emplace(std::upper_bound(index.begin(), index.end(), std::pair(type, scripts.size())), type, scripts.size());
+	if(home) home->enroll(script, detail::hooks_of<T>());
+#ifdef TUNA_PROFILE
+	if(home) {
+		if(type >= home->profiler.names.size() || !*home->profiler.names[type]) home->profiler.name(type, typeid(T).name());
+		++home->profiler.frame.grants;
+	}
+#endif
+	scripts.emplace_back(std::move(iscript));
+	return;
+}
+
+template<typename T>
+bool Object::take(void) {
+	auto found = find<T>();
+	if(found == scripts.end()) return false;
+
+	const std::size_t position = found - scripts.begin();
+	std::erase_if(index, [&](const std::pair<std::size_t, std::size_t>& ientry) {
+		return ientry.second == position;
+	});
+	for(auto& entry : index) if(entry.second > position) --entry.second;
+	(*found)->holder = nullptr;
+	++revision;
+
+	if(home) {
+#ifdef TUNA_PROFILE
+		++home->profiler.frame.takes;
+#endif
+		home->delist(found->get());
+		home->bury(std::move(*found));
+	}
+	scripts.erase(found);
+	return true;
+}
+
+template<typename T>
+Ref<T> Object::ref(void) {
+	if(!home) return Ref<T>();
+	T* script = peek<T>();
+	if(!script) return Ref<T>();
+	return Ref<T>(home, id, revision, script);
+}
+
+// Register a type for World::save() and World::load():
+//     Scripts need a default constructor and
+//     save(Writer&) const and load(Reader&)
+//     methods. Components must be trivially
+//     copyable and are written as they are.
+//     The name identifies the type in blobs.
+template<typename T>
+void serializable(std::string_view iname) {
+	const std::size_t type = detail::type_of<T>();
+	auto& table = detail::serializers();
+	if(type >= table.size()) table.resize(type + 1);
+
+	detail::Serializer& entry = table[type];
+	entry.name = iname;
+	if constexpr(std::is_base_of_v<Script, T>) {
+		entry.save = [](const Script& iscript, Writer& iwriter) {
+			static_cast<const T&>(iscript).save(iwriter);
+			return;
+		};
+		entry.read = [](Script& iscript, Reader& ireader) {
+			static_cast<T&>(iscript).load(ireader);
+			return !ireader.failed();
+		};
+		entry.load = [](Object& iobject, Reader& ireader) -> Script* {
+			T* script = iobject.grant<T>().lock().get();
+			return detail::serializers()[detail::type_of<T>()].read(*script, ireader) ? script : nullptr;
+		};
+	}
+	else {
+		static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>, "Components must be trivially copyable");
+		entry.pool = [](void) -> std::unique_ptr<detail::Pool> { return std::make_unique<detail::Components<T>>(); };
+	}
+	return;
+}
+
+inline void World::run(const Schedule& ischedule, const float DELTA_TIME) {
+	sync();
+	++dispatching;
+	for(const auto& wave : ischedule.waves) {
+		// Parallel dispatches can not nest
+		if(wave.size() > 1 && !parallel) {
+			parallel = true;
+			Jobs::shared().run(wave.size(), [&](std::size_t ibegin, std::size_t iend) {
+				for(std::size_t i = ibegin; i < iend; ++i)
+					ischedule.phases[wave[i]].shared(*this, DELTA_TIME);
+				return;
+			}, 1);
+			parallel = false;
+			continue;
+		}
+		for(std::size_t index : wave) ischedule.phases[index].alone(*this, DELTA_TIME);
+	}
+	if(--dispatching == 0) settle();
+	return;
+}
+
+inline bool Script::start(Task&& itask) {
+	World* world = holder ? holder->world() : nullptr;
+	if(!world || !itask.handle || !world->alive(holder->id)) return false;
+	world->launch(std::exchange(itask.handle, nullptr), holder->id, type, serial);
+	return true;
+}
+
+inline void Wait::await_suspend(std::coroutine_handle<Task::promise_type> ihandle) const {
+	ihandle.promise().home->suspend(ihandle, seconds);
+	return;
+}
+
+inline void Script::sleep(void) {
+	if(asleep) return;
+	asleep = true;
+	if(World* world = holder ? holder->world() : nullptr) world->unlist(this);
+	return;
+}
+
+inline void Script::wake(void) {
+	if(!asleep) return;
+	asleep = false;
+	if(World* world = holder ? holder->world() : nullptr) world->enroll(this, hooks);
+	return;
+}
+
+template<typename T>
+bool Object::pace(std::size_t iinterval) {
+	auto found = find<T>();
+	if(!home || found == scripts.end()) return false;
+	home->pace(found->get(), iinterval);
+	return true;
+}
+
+inline bool Object::place(const Bounds& ibounds) {
+	if(!home) return false;
+	return home->place(id, ibounds);
+}
+
+template<typename E, typename T>
+bool Object::subscribe(void) {
+	if(!home) return false;
+	return home->subscribe<E, T>(id);
+}
+template<typename E, typename T>
+bool Object::unsubscribe(void) {
+	if(!home) return false;
+	return home->unsubscribe<E, T>(id);
+}
+
+template<typename T, typename... ARGS>
+T* Object::attach(ARGS&&... iargs) {
+	if(!home) return nullptr;
+	return home->attach<T>(id, std::forward<ARGS>(iargs)...);
+}
+
+template<typename T>
+T* Object::component(void) {
+	if(!home) return nullptr;
+	return home->component<T>(id);
+}
+
+template<typename T>
+bool Object::detach(void) {
+	if(!home) return false;
+	return home->detach<T>(id);
+}
+
+template<typename T>
+Ref<T>::Ref(World* iworld, ObjectID iid, std::uint32_t irevision, T* ipointer)
+	: home(iworld), id(iid), revision(irevision), epoch(iworld->epoch), pointer(ipointer) { return; }
+
+template<typename T>
+bool Ref<T>::valid(void) const {
+	if(!home || home->epoch != epoch) return false;
+	auto found = home->objects.find(id);
+	if(found == home->objects.end() || !found->second) return false;
+	if constexpr(std::is_same_v<T, Object>) return true;
+	else return found->second->revision == revision;
+}
+
 } // namespace tuna
 
 	// QoL marcos